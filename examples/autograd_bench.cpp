@@ -0,0 +1,176 @@
+#include "mini_tf.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+using mtf::autograd::NodePtr;
+
+// The sort Engine used before: recursion through a std::function and a hash
+// set of shared_ptrs.
+std::vector<NodePtr> recursive_sort(NodePtr root) {
+    std::vector<NodePtr> sorted;
+    std::unordered_set<NodePtr> visited;
+    std::function<void(NodePtr)> visit = [&](NodePtr node) {
+        if (!node || visited.count(node)) return;
+        visited.insert(node);
+        for (auto& parent : node->parents) {
+            visit(parent);
+        }
+        sorted.push_back(node);
+    };
+    visit(root);
+    return sorted;
+}
+
+template <typename Fn>
+double time_ms(Fn fn) {
+    fn();
+    int iters = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        ++iters;
+        elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 500.0);
+    return elapsed / iters;
+}
+
+// An unrolled recurrence h = tanh(h * w + x_t) over `steps` steps, three nodes
+// per step, so the graph is as deep as it is large.
+NodePtr chain(size_t steps, const NodePtr& w, const NodePtr& h0) {
+    NodePtr h = h0;
+    for (size_t t = 0; t < steps; ++t) {
+        auto x = mtf::Variable({1, 4});
+        h = mtf::nn::functional::tanh(h * w + x);
+    }
+    return h;
+}
+
+// Many leaves added up in a balanced tree: shallow, and every leaf is a
+// separate input with its own gradient.
+NodePtr tree(size_t leaves, const NodePtr& w) {
+    std::vector<NodePtr> level;
+    for (size_t i = 0; i < leaves; ++i) {
+        level.push_back(mtf::Variable({1, 4}, true) * w);
+    }
+    while (level.size() > 1) {
+        std::vector<NodePtr> next;
+        for (size_t i = 0; i + 1 < level.size(); i += 2) next.push_back(level[i] + level[i + 1]);
+        if (level.size() % 2) next.push_back(level.back());
+        level = std::move(next);
+    }
+    return level[0];
+}
+
+void report(const char* name, const NodePtr& root, bool run_recursive) {
+    size_t nodes = mtf::autograd::Engine::topological_sort(root).size();
+    double iterative = time_ms([&] { mtf::autograd::Engine::topological_sort(root); });
+    double reused = time_ms([&] { mtf::autograd::Engine::backward(root); });
+    // Alternating with a graph of another shape makes every call sort.
+    auto other = mtf::Variable({1, 4}, true) * mtf::Variable({1, 4}, true);
+    double sorted = time_ms([&] {
+        mtf::autograd::Engine::backward(root);
+        mtf::autograd::Engine::backward(other);
+    });
+
+    std::cout << std::setw(10) << name << " | " << std::setw(7) << nodes << " | " << std::fixed
+              << std::setprecision(2);
+    if (run_recursive) {
+        double recursive = time_ms([&] { recursive_sort(root); });
+        std::cout << std::setw(9) << recursive << " " << std::setw(9) << iterative << " "
+                  << std::setw(6) << recursive / iterative << "x";
+    } else {
+        std::cout << std::setw(9) << "overflow" << " " << std::setw(9) << iterative << " " << std::setw(7) << "-";
+    }
+    std::cout << " | " << std::setw(8) << reused << " " << std::setw(8) << sorted << std::endl;
+}
+
+// A shared trunk feeding `heads` independent heads, one MSE loss per head,
+// summed: the heads' backward passes only meet again in the trunk.
+struct Branches {
+    mtf::nn::Dense trunk;
+    std::vector<mtf::nn::Dense> heads;
+    std::vector<mtf::nn::Dense> outs;
+
+    Branches(size_t width, size_t count) : trunk(width, width) {
+        for (size_t i = 0; i < count; ++i) {
+            heads.emplace_back(width, width);
+            outs.emplace_back(width, 1);
+        }
+    }
+
+    NodePtr loss(const NodePtr& x, const NodePtr& y) {
+        mtf::nn::MSELoss criterion;
+        auto h = mtf::nn::functional::relu(trunk(x));
+        NodePtr total;
+        for (size_t i = 0; i < heads.size(); ++i) {
+            auto l = criterion(outs[i](mtf::nn::functional::tanh(heads[i](h))), y);
+            total = total ? total + l : l;
+        }
+        return total;
+    }
+
+    std::vector<NodePtr> parameters() const {
+        auto params = trunk.parameters();
+        for (size_t i = 0; i < heads.size(); ++i) {
+            for (const auto& p : heads[i].parameters()) params.push_back(p);
+            for (const auto& p : outs[i].parameters()) params.push_back(p);
+        }
+        return params;
+    }
+};
+
+void report_branches(size_t heads, size_t threads) {
+    mtf::core::set_num_threads(threads);
+    Branches model(128, heads);
+    auto x = mtf::Variable({64, 128});
+    auto y = mtf::Variable({64, 1});
+    auto params = model.parameters();
+
+    auto grads = [&](bool parallel) {
+        for (auto& p : params) p->zero_grad();
+        auto loss = model.loss(x, y);
+        if (parallel) {
+            mtf::autograd::Engine::backward_parallel(loss);
+        } else {
+            mtf::autograd::Engine::backward(loss);
+        }
+        std::vector<float> all;
+        for (auto& p : params) all.insert(all.end(), p->grad.data(), p->grad.data() + p->grad.size());
+        return all;
+    };
+    std::vector<float> serial = grads(false);
+    std::vector<float> parallel = grads(true);
+    bool same = serial.size() == parallel.size() &&
+                std::memcmp(serial.data(), parallel.data(), serial.size() * sizeof(float)) == 0;
+
+    auto loss = model.loss(x, y);
+    double serial_ms = time_ms([&] { mtf::autograd::Engine::backward(loss); });
+    double parallel_ms = time_ms([&] { mtf::autograd::Engine::backward_parallel(loss); });
+    std::cout << std::setw(5) << heads << " | " << std::setw(7) << threads << " | " << std::fixed
+              << std::setprecision(3) << std::setw(8) << serial_ms << " " << std::setw(8) << parallel_ms << " "
+              << std::setprecision(2) << std::setw(5) << serial_ms / parallel_ms << "x | "
+              << (same ? "identical" : "DIFFERENT") << std::endl;
+}
+
+int main() {
+    auto w = mtf::Variable({1, 4}, true);
+    auto h0 = mtf::Variable({1, 4}, true);
+
+    std::cout << "     graph |   nodes |   sort ms: recursive iterative      | backward ms: reused   sorted" << std::endl;
+    report("tree", tree(50000, w), true);
+    report("chain 2k", chain(2000, w, h0), true);
+    // Recursing 1e5+ frames deep overflows the default 8 MiB stack.
+    report("chain 50k", chain(50000, w, h0), false);
+
+    std::cout << "\nheads | threads | backward ms: serial parallel | grads vs serial" << std::endl;
+    size_t threads = std::max<size_t>(mtf::core::get_num_threads(), 4);
+    for (size_t heads : {1, 4, 16}) report_branches(heads, threads);
+    return 0;
+}
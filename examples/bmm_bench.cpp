@@ -0,0 +1,85 @@
+#include "mini_tf.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using mtf::core::Tensor;
+
+struct Case {
+    size_t batch_a, batch_b, M, K, N;
+};
+
+// What user code did before bmm: copy out each pair of slices, multiply them
+// with the 2-D kernel and copy the product into the result.
+Tensor looped_matmul(const Tensor& a, const Tensor& b, size_t batch) {
+    size_t M = a.shape()[1];
+    size_t N = b.shape()[2];
+    Tensor result({batch, M, N});
+    for (size_t p = 0; p < batch; ++p) {
+        size_t pa = a.shape()[0] == 1 ? 0 : p;
+        size_t pb = b.shape()[0] == 1 ? 0 : p;
+        Tensor a_p = a.slice(0, pa, pa + 1).reshape({M, a.shape()[2]}).contiguous();
+        Tensor b_p = b.slice(0, pb, pb + 1).reshape({b.shape()[1], N}).contiguous();
+        Tensor c_p = mtf::core::ops::matmul(a_p, b_p);
+        std::memcpy(result.data() + p * M * N, c_p.data(), M * N * sizeof(float));
+    }
+    return result;
+}
+
+template <typename Fn>
+double time_ms(Fn fn) {
+    fn();
+    int iters = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        ++iters;
+        elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 300.0);
+    return elapsed / iters;
+}
+
+int main() {
+    const std::vector<Case> cases = {
+        {256, 256, 32, 32, 32},     // many tiny products
+        {64, 64, 128, 64, 128},     // attention scores
+        {64, 64, 128, 128, 64},     // attention-weighted values
+        {8, 8, 256, 256, 256},
+        {32, 1, 128, 256, 256},     // shared weight broadcast over the batch
+    };
+
+    std::cout << "Kernels: " << mtf::core::isa_name(mtf::core::active_isa())
+              << ", threads: " << mtf::core::get_num_threads() << std::endl;
+    std::cout << "  batch      M x    K x    N |  loop ms   bmm ms  speedup | bmm GFLOP/s | max abs diff" << std::endl;
+    for (const auto& c : cases) {
+        size_t batch = std::max(c.batch_a, c.batch_b);
+        Tensor a({c.batch_a, c.M, c.K});
+        Tensor b({c.batch_b, c.K, c.N});
+        a.randn();
+        b.randn();
+
+        Tensor ref = looped_matmul(a, b, batch);
+        Tensor y = mtf::core::ops::bmm(a, b);
+        double diff = 0.0;
+        for (size_t i = 0; i < ref.size(); ++i) {
+            diff = std::max(diff, static_cast<double>(std::fabs(y[i] - ref[i])));
+        }
+
+        double loop_ms = time_ms([&] { looped_matmul(a, b, batch); });
+        double bmm_ms = time_ms([&] { mtf::core::ops::bmm(a, b); });
+        double flops = 2.0 * batch * c.M * c.N * c.K;
+
+        std::cout << std::setw(3) << c.batch_a << "x" << std::setw(3) << c.batch_b << " "
+                  << std::setw(6) << c.M << " x" << std::setw(5) << c.K << " x" << std::setw(5) << c.N << " | "
+                  << std::fixed << std::setprecision(3) << std::setw(8) << loop_ms << " "
+                  << std::setw(8) << bmm_ms << " " << std::setprecision(2) << std::setw(7) << loop_ms / bmm_ms << "x | "
+                  << std::setw(11) << flops / bmm_ms * 1e-6 << " | "
+                  << std::scientific << std::setprecision(1) << diff << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "mini_tf.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using mtf::core::Tensor;
+
+struct Model {
+    mtf::nn::Dense fc1;
+    mtf::nn::Dense fc2;
+
+    Model(size_t in, size_t hidden, size_t out) : fc1(in, hidden), fc2(hidden, out) {}
+
+    std::vector<mtf::autograd::NodePtr> parameters() const {
+        auto params = fc1.parameters();
+        auto params2 = fc2.parameters();
+        params.insert(params.end(), params2.begin(), params2.end());
+        return params;
+    }
+};
+
+double max_diff(const Model& a, const Model& b) {
+    double diff = 0.0;
+    auto pa = a.parameters();
+    auto pb = b.parameters();
+    for (size_t i = 0; i < pa.size(); ++i) {
+        for (size_t j = 0; j < pa[i]->value.size(); ++j) {
+            diff = std::max(diff, static_cast<double>(std::fabs(pa[i]->value[j] - pb[i]->value[j])));
+        }
+    }
+    return diff;
+}
+
+// Trains two copies of the same network on the same batches, one building the
+// graph every step and one replaying a captured step, and times both. A last
+// step with a smaller batch makes the captured one capture again.
+template <typename Optimizer, typename Criterion, typename Net>
+void run(const std::string& name, size_t in, size_t hidden, size_t out, size_t batch, int steps,
+         const Tensor& x_data, const Tensor& y_data, Net net, float learning_rate) {
+    mtf::manual_seed(42);
+    Model eager(in, hidden, out);
+    mtf::manual_seed(42);
+    Model captured(in, hidden, out);
+
+    Optimizer eager_opt(eager.parameters(), learning_rate);
+    Optimizer captured_opt(captured.parameters(), learning_rate);
+    Criterion criterion;
+
+    const size_t batches = x_data.shape()[0] / batch;
+    auto batch_of = [&](const Tensor& data, int step, size_t rows) {
+        size_t begin = (static_cast<size_t>(step) % batches) * batch;
+        return data.slice(0, begin, begin + rows).contiguous();
+    };
+
+    auto x = mtf::Variable(batch_of(x_data, 0, batch), false);
+    auto y = mtf::Variable(batch_of(y_data, 0, batch), false);
+
+    auto eager_step = [&](int step, size_t rows) {
+        auto xb = mtf::Variable(batch_of(x_data, step, rows), false);
+        auto yb = mtf::Variable(batch_of(y_data, step, rows), false);
+        auto loss = criterion(net(eager, xb), yb);
+        eager_opt.zero_grad();
+        mtf::autograd::Engine::backward(loss);
+        eager_opt.step();
+        return loss->value[0];
+    };
+    mtf::CapturedStep step([&] { return criterion(net(captured, x), y); }, captured_opt);
+    auto captured_step = [&](int i, size_t rows) {
+        x->value = batch_of(x_data, i, rows);
+        y->value = batch_of(y_data, i, rows);
+        return step.step()->value[0];
+    };
+
+    bool same_losses = true;
+    for (int i = 0; i < steps; ++i) {
+        same_losses = same_losses && eager_step(i, batch) == captured_step(i, batch);
+    }
+    same_losses = same_losses && eager_step(steps, batch / 2) == captured_step(steps, batch / 2);
+    double diff = max_diff(eager, captured);
+    size_t captures = step.captures();
+
+    auto time_us = [&](auto fn) {
+        int iters = 0;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        do {
+            for (int i = 0; i < 50; ++i) fn(iters + i, batch);
+            iters += 50;
+            elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < 500000.0);
+        return elapsed / iters;
+    };
+    double eager_us = time_us(eager_step);
+    double captured_us = time_us(captured_step);
+
+    std::cout << std::setw(22) << name << " | " << std::fixed << std::setprecision(2)
+              << std::setw(9) << eager_us << " " << std::setw(9) << captured_us << " "
+              << std::setw(6) << eager_us / captured_us << "x | "
+              << (same_losses ? "same" : "DIFFERENT") << " " << std::scientific << std::setprecision(0)
+              << diff << " | " << captures << std::endl;
+}
+
+int main() {
+    std::cout << "                 model |     step us (eager, captured)  | losses, weight diff | captures" << std::endl;
+
+    // 4-bit parity, the xor_train.cpp network.
+    std::vector<float> x_raw, y_raw;
+    for (size_t i = 0; i < 16; ++i) {
+        int ones = 0;
+        for (size_t b = 0; b < 4; ++b) {
+            int bit = (i >> (3 - b)) & 1;
+            ones += bit;
+            x_raw.push_back(static_cast<float>(bit));
+        }
+        y_raw.push_back(static_cast<float>(ones % 2));
+    }
+    Tensor xor_x({16, 4}, x_raw);
+    Tensor xor_y({16, 1}, y_raw);
+    run<mtf::optim::SGD, mtf::nn::MSELoss>("4-32-1 x16 SGD", 4, 32, 1, 16, 200, xor_x, xor_y,
+        [](Model& m, const mtf::autograd::NodePtr& x) {
+            return mtf::nn::functional::sigmoid(m.fc2(mtf::nn::functional::tanh(m.fc1(x))));
+        }, 0.5f);
+
+    // The mnist_train.cpp network on random data.
+    mtf::manual_seed(7);
+    Tensor mnist_x({32 * 20, 784});
+    mnist_x.rand(0.0f, 1.0f);
+    Tensor mnist_y({32 * 20, 10});
+    mnist_y.fill(0.0f);
+    for (size_t i = 0; i < mnist_y.shape()[0]; ++i) mnist_y[{i, i % 10}] = 1.0f;
+    run<mtf::optim::Adam, mtf::nn::CrossEntropyLoss>("784-128-10 x32 Adam", 784, 128, 10, 32, 20, mnist_x, mnist_y,
+        [](Model& m, const mtf::autograd::NodePtr& x) {
+            return mtf::nn::functional::softmax(m.fc2(mtf::nn::functional::relu(m.fc1(x))));
+        }, 0.001f);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "mini_tf.hpp"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using mtf::core::Tensor;
+namespace ops = mtf::core::ops;
+namespace lazy = mtf::core::lazy;
+
+template <typename Fn>
+double time_ms(Fn fn, int iters) {
+    fn();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; ++i) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iters;
+}
+
+double max_abs_diff(const Tensor& x, const Tensor& y) {
+    double err = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        err = std::max(err, std::abs(static_cast<double>(x[i]) - y[i]));
+    }
+    return err;
+}
+
+void report(const std::string& name, double eager_ms, double lazy_ms, double err) {
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(9) << eager_ms << " ms" << std::setw(9) << lazy_ms << " ms"
+              << std::setw(8) << eager_ms / lazy_ms << "x | " << std::scientific << std::setprecision(1)
+              << err << std::endl;
+}
+
+int main() {
+    const size_t rows = 4096;
+    const size_t cols = 1024;
+    const int iters = 20;
+
+    Tensor a({rows, cols});
+    Tensor b({rows, cols});
+    Tensor c({rows, cols});
+    Tensor bias({cols});
+    a.randn();
+    b.randn();
+    c.randn();
+    bias.randn();
+
+    std::cout << rows << " x " << cols << " floats, " << iters << " iterations" << std::endl;
+    std::cout << "expression                     eager         lazy   speedup | max abs diff" << std::endl;
+
+    {
+        Tensor eager, fused;
+        double te = time_ms([&] { eager = ops::mul_scalar(ops::add(ops::mul(a, b), c), 0.5f); }, iters);
+        double tl = time_ms([&] { fused = lazy::mul_scalar(lazy::add(lazy::mul(a, b), c), 0.5f); }, iters);
+        report("(a * b + c) * 0.5", te, tl, max_abs_diff(eager, fused));
+    }
+    {
+        Tensor eager, fused;
+        double te = time_ms([&] { eager = ops::relu(ops::add(ops::mul(a, b), bias)); }, iters);
+        double tl = time_ms([&] { fused = lazy::relu(lazy::add(lazy::mul(a, b), bias)); }, iters);
+        report("relu(a * b + bias)", te, tl, max_abs_diff(eager, fused));
+    }
+    {
+        Tensor out({rows, cols});
+        Tensor eager;
+        double te = time_ms([&] { eager = ops::add(a, ops::mul_scalar(ops::sub(b, c), 0.1f)); }, iters);
+        double tl = time_ms([&] { lazy::assign(out, lazy::add(a, lazy::mul_scalar(lazy::sub(b, c), 0.1f))); }, iters);
+        report("a + (b - c) * 0.1 (assign)", te, tl, max_abs_diff(eager, out));
+    }
+    return 0;
+}
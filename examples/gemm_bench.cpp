@@ -0,0 +1,118 @@
+#include "mini_tf.hpp"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+struct Shape {
+    size_t M, K, N;
+};
+
+mtf::core::Tensor naive_matmul(const mtf::core::Tensor& a, const mtf::core::Tensor& b) {
+    size_t M = a.shape()[0];
+    size_t K = a.shape()[1];
+    size_t N = b.shape()[1];
+    mtf::core::Tensor c({M, N});
+    c.fill(0.0f);
+    for (size_t i = 0; i < M; ++i) {
+        for (size_t k = 0; k < K; ++k) {
+            float val_a = a[i * K + k];
+            for (size_t j = 0; j < N; ++j) {
+                c[i * N + j] += val_a * b[k * N + j];
+            }
+        }
+    }
+    return c;
+}
+
+double max_rel_error(const mtf::core::Tensor& x, const mtf::core::Tensor& ref) {
+    double err = 0.0;
+    for (size_t i = 0; i < ref.size(); ++i) {
+        double diff = std::abs(static_cast<double>(x[i]) - ref[i]);
+        err = std::max(err, diff / (std::abs(static_cast<double>(ref[i])) + 1.0));
+    }
+    return err;
+}
+
+void run(const Shape& s, mtf::core::DType dtype, bool prepacked = false, const char* label = nullptr) {
+    mtf::core::Tensor a({s.M, s.K});
+    mtf::core::Tensor b({s.K, s.N});
+    a.randn();
+    b.randn();
+    a = a.to(dtype);
+    b = b.to(dtype);
+
+    mtf::core::PackedMatrix packed_b;
+    if (prepacked) {
+        packed_b = mtf::core::ops::pack_gemm_rhs(b);
+    }
+    auto multiply = [&]() {
+        if (!prepacked) {
+            return mtf::core::ops::matmul(a, b);
+        }
+        mtf::core::Tensor out({s.M, s.N});
+        mtf::core::ops::gemm(false, 1.0f, a, packed_b, 0.0f, out);
+        return out;
+    };
+
+    auto c = multiply();
+    double err = max_rel_error(c, naive_matmul(a.to(mtf::core::DType::Float32),
+                                               b.to(mtf::core::DType::Float32)));
+
+    double flops = 2.0 * s.M * s.N * s.K;
+    int iters = static_cast<int>(std::max(1.0, 2e9 / flops));
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; ++i) {
+        c = multiply();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    if (!label) label = prepacked ? "prepack" : mtf::core::dtype_name(dtype);
+    std::cout << std::setw(8) << label << " | "
+              << std::setw(5) << s.M << " x " << std::setw(5) << s.K << " x " << std::setw(5) << s.N
+              << " | " << std::setw(8) << std::fixed << std::setprecision(2) << flops * iters / seconds * 1e-9
+              << " GFLOP/s | " << std::scientific << std::setprecision(1) << err << std::endl;
+}
+
+int main() {
+    std::vector<Shape> shapes = {
+        {32, 784, 128},
+        {32, 128, 10},
+        {128, 784, 128},
+        {256, 256, 256},
+        {512, 512, 512},
+        {1024, 1024, 1024},
+    };
+
+    std::cout << "Kernels: " << mtf::core::isa_name(mtf::core::active_isa())
+              << " (set MTF_CPU_ISA to override)" << std::endl;
+    std::cout << "   dtype |     M x     K x     N |  throughput     | max rel err" << std::endl;
+    for (const auto& s : shapes) {
+        run(s, mtf::core::DType::Float32);
+    }
+    // 16-bit operands are widened while packing and accumulated in float32.
+    for (auto dtype : {mtf::core::DType::BFloat16, mtf::core::DType::Float16}) {
+        run({128, 784, 128}, dtype);
+        run({512, 512, 512}, dtype);
+    }
+    // float32 with B packed once up front, as frozen Dense layers do.
+    for (const auto& s : {Shape{1, 784, 256}, Shape{32, 784, 128}, Shape{512, 512, 512}}) {
+        run(s, mtf::core::DType::Float32);
+        run(s, mtf::core::DType::Float32, true);
+    }
+    // float32 with operands on 4 KiB pages, as with MTF_HUGEPAGE_MB=0, and then
+    // on 2 MiB huge pages.
+    const size_t threshold = mtf::core::hugepage_threshold();
+    for (const auto& s : {Shape{1024, 1024, 1024}, Shape{2048, 2048, 2048}}) {
+        for (bool huge : {false, true}) {
+            mtf::core::set_hugepage_threshold(huge ? (threshold > 0 ? threshold : size_t(2) << 20) : 0);
+            mtf::core::empty_cache();
+            run(s, mtf::core::DType::Float32, false, huge ? "2M pages" : "4K pages");
+        }
+    }
+    mtf::core::set_hugepage_threshold(threshold);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "mini_tf.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using mtf::core::Tensor;
+
+// Single-request latency of an MLP, one input row at a time as model_load
+// serves it: the trainable graph path against frozen layers, which take the
+// matrix-vector path with bias and activation fused.
+
+struct Model {
+    std::string name;
+    std::vector<size_t> dims;
+};
+
+std::vector<mtf::nn::Dense> make_layers(const std::vector<size_t>& dims) {
+    std::vector<mtf::nn::Dense> layers;
+    for (size_t i = 0; i + 1 < dims.size(); ++i) {
+        layers.emplace_back(dims[i], dims[i + 1]);
+        layers.back().bias()->value.randn(0.0f, 0.1f);
+    }
+    return layers;
+}
+
+Tensor forward_graph(std::vector<mtf::nn::Dense>& layers, const Tensor& x) {
+    auto h = mtf::Variable(x, false);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        h = layers[i](h);
+        if (i + 1 < layers.size()) h = mtf::nn::functional::relu(h);
+    }
+    return h->value;
+}
+
+Tensor forward_frozen(std::vector<mtf::nn::Dense>& layers, const Tensor& x) {
+    mtf::NoGradGuard no_grad;
+    auto h = mtf::Variable(x, false);
+    for (auto& layer : layers) {
+        h = layer(h);
+    }
+    return h->value;
+}
+
+struct Latency {
+    double p50, p99, max;  // microseconds
+};
+
+template <typename Fn>
+Latency measure(Fn fn, size_t requests) {
+    for (size_t i = 0; i < requests / 10 + 1; ++i) fn();
+    std::vector<double> us(requests);
+    for (size_t i = 0; i < requests; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        us[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::sort(us.begin(), us.end());
+    return {us[requests / 2], us[requests * 99 / 100], us.back()};
+}
+
+void print(const std::string& model, const std::string& path, const Latency& l, double err) {
+    std::cout << std::setw(20) << model << " | " << std::setw(6) << path << " | "
+              << std::fixed << std::setprecision(1)
+              << std::setw(9) << l.p50 << " " << std::setw(9) << l.p99 << " " << std::setw(9) << l.max
+              << " | " << std::scientific << std::setprecision(1) << err << std::endl;
+}
+
+int main() {
+    const std::vector<Model> models = {
+        {"784-256-128-10", {784, 256, 128, 10}},
+        {"1024-1024-1024-10", {1024, 1024, 1024, 10}},
+        {"4096-4096-10", {4096, 4096, 10}},
+    };
+
+    std::cout << "Kernels: " << mtf::core::isa_name(mtf::core::active_isa())
+              << ", threads: " << mtf::core::get_num_threads() << std::endl;
+    std::cout << "               model |   path |   p50 us    p99 us    max us | max rel err" << std::endl;
+    for (const auto& m : models) {
+        auto graph = make_layers(m.dims);
+        auto frozen = graph;
+        for (size_t i = 0; i < frozen.size(); ++i) {
+            frozen[i].freeze();
+            if (i + 1 < frozen.size()) frozen[i].set_activation(mtf::core::ops::Activation::Relu);
+        }
+
+        Tensor x({1, m.dims[0]});
+        x.randn();
+        Tensor ref = forward_graph(graph, x);
+        Tensor y = forward_frozen(frozen, x);
+        double err = 0.0;
+        for (size_t j = 0; j < ref.size(); ++j) {
+            err = std::max(err, std::fabs(static_cast<double>(y[j]) - ref[j]) / (std::fabs(ref[j]) + 1.0));
+        }
+
+        size_t macs = 0;
+        for (size_t i = 0; i + 1 < m.dims.size(); ++i) macs += m.dims[i] * m.dims[i + 1];
+        size_t requests = std::max<size_t>(200, std::min<size_t>(20000, 2000000000 / macs / 20));
+
+        print(m.name, "graph", measure([&] { forward_graph(graph, x); }, requests), 0.0);
+        print(m.name, "frozen", measure([&] { forward_frozen(frozen, x); }, requests), err);
+    }
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include <vector>
 #include <fstream>
 #include <iomanip>
+#include <cmath>
 
 void train_mnist() {
     std::cout << "Starting MNIST training..." << std::endl;
@@ -26,27 +27,34 @@ void train_mnist() {
 
     std::cout << "Training on dummy data (checking flow)..." << std::endl;
 
+    size_t steps = 100;
+    size_t num_samples = steps * batch_size;
+
+    mtf::core::Tensor x_dataset({num_samples, input_dim});
+    // Normalize random data to be more realistic (0-1 range roughly)
+    x_dataset.randn(0.0f, 0.5f);
+    // Clamp to avoid large values which might saturate sigmoid/exp
+    for(size_t i=0; i<x_dataset.size(); ++i) x_dataset[i] = std::abs(x_dataset[i]);
+
+    mtf::core::Tensor y_dataset({num_samples, output_dim});
+    y_dataset.fill(0.0f);
+    for(size_t i=0; i<num_samples; ++i) {
+        int label = rand() % 10;
+        y_dataset[{i, static_cast<size_t>(label)}] = 1.0f;
+    }
+
     for (int epoch = 0; epoch < epochs; ++epoch) {
         float total_loss = 0.0f;
-        int steps = 100;
-
-        for (int step = 0; step < steps; ++step) {
-            mtf::core::Tensor x_data({batch_size, input_dim});
-            // Normalize random data to be more realistic (0-1 range roughly)
-            x_data.randn(0.0f, 0.5f); 
-            // Clamp to avoid large values which might saturate sigmoid/exp
-            for(size_t i=0; i<x_data.size(); ++i) x_data[i] = std::abs(x_data[i]); 
-            
-            auto x = mtf::Variable(x_data, false);
 
-            mtf::core::Tensor y_data({batch_size, output_dim});
-            y_data.fill(0.0f);
-            
-            for(size_t i=0; i<batch_size; ++i) {
-                int label = rand() % 10;
-                y_data[{i, static_cast<size_t>(label)}] = 1.0f;
-            }
-            auto y = mtf::Variable(y_data, false);
+        for (size_t step = 0; step < steps; ++step) {
+            // Graph nodes and temporaries of this step live in the arena and are
+            // released together when `scope` goes out of scope.
+            mtf::StepArena scope;
+
+            // Batches are views into the dataset, no rows are copied.
+            size_t begin = step * batch_size;
+            auto x = mtf::Variable(x_dataset.slice(0, begin, begin + batch_size), false);
+            auto y = mtf::Variable(y_dataset.slice(0, begin, begin + batch_size), false);
 
             auto h1 = fc1(x);
             auto a1 = mtf::nn::functional::relu(h1);
@@ -55,13 +55,13 @@ void print_prediction(const mtf::autograd::NodePtr& output, const mtf::nn::Model
     }
 }
 
-mtf::autograd::NodePtr forward_pass(std::vector<mtf::nn::Dense>& layers, 
+mtf::autograd::NodePtr forward_pass(const std::vector<mtf::nn::Layer*>& layers, 
                                      const std::vector<std::string>& activations,
                                      mtf::autograd::NodePtr input) {
     auto x = input;
     
     for (size_t i = 0; i < layers.size(); ++i) {
-        x = layers[i](x);
+        x = (*layers[i])(x);
         
         if (i < activations.size() && !activations[i].empty()) {
             const std::string& act = activations[i];
@@ -82,10 +82,17 @@ mtf::autograd::NodePtr forward_pass(std::vector<mtf::nn::Dense>& layers,
 
 int main(int argc, char* argv[]) {
     std::string model_path;
+    bool int8 = false;
     
-    if (argc > 1) {
-        model_path = argv[1];
-    } else {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--int8") {
+            int8 = true;
+        } else if (model_path.empty()) {
+            model_path = arg;
+        }
+    }
+    if (model_path.empty()) {
         std::cout << "Enter model path (e.g., models/xor): ";
         std::getline(std::cin, model_path);
     }
@@ -129,6 +136,36 @@ int main(int argc, char* argv[]) {
         std::cerr << "Error: No layers loaded!" << std::endl;
         return 1;
     }
+
+    // Activations after a layer are fused into it where the layer supports
+    // them. --int8 swaps in quantized copies of the layers, which keep them.
+    std::vector<std::string> activations = metadata.activations;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const std::string act = i < activations.size() ? activations[i] : "";
+        if (act == "relu") {
+            layers[i].set_activation(mtf::core::ops::Activation::Relu);
+        } else if (act == "sigmoid") {
+            layers[i].set_activation(mtf::core::ops::Activation::Sigmoid);
+        } else if (act == "tanh") {
+            layers[i].set_activation(mtf::core::ops::Activation::Tanh);
+        } else {
+            continue;
+        }
+        activations[i].clear();
+    }
+
+    std::vector<mtf::nn::QuantizedDense> quantized;
+    std::vector<mtf::nn::Layer*> model;
+    if (int8) {
+        quantized.reserve(layers.size());
+        for (const auto& layer : layers) {
+            quantized.emplace_back(layer);
+            model.push_back(&quantized.back());
+        }
+        std::cout << "Running int8 quantized layers" << std::endl;
+    } else {
+        for (auto& layer : layers) model.push_back(&layer);
+    }
     std::cout << "\n" << metadata.input_description << std::endl;
     std::cout << "Example: " << metadata.input_example << std::endl;
     std::cout << "Type 'quit' to exit\n" << std::endl;
@@ -151,10 +188,11 @@ int main(int argc, char* argv[]) {
         }
         
         try {
+            mtf::NoGradGuard no_grad;
             auto x_tensor = mtf::core::Tensor({1, metadata.input_dim}, input_data);
             auto x = mtf::Variable(x_tensor, false);
             
-            auto output = forward_pass(layers, metadata.activations, x);
+            auto output = forward_pass(model, activations, x);
             
             std::cout << "Input: ";
             for (size_t i = 0; i < input_data.size(); ++i) {
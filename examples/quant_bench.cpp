@@ -0,0 +1,134 @@
+#include "mini_tf.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using mtf::core::Tensor;
+
+// MNIST-sized MLP: 784 -> 256 -> 128 -> 10 with ReLU between layers.
+const std::vector<size_t> DIMS = {784, 256, 128, 10};
+
+Tensor pixels(size_t batch, std::mt19937& gen) {
+    std::uniform_real_distribution<float> d(0.0f, 1.0f);
+    Tensor x({batch, DIMS[0]});
+    for (size_t i = 0; i < x.size(); ++i) x[i] = d(gen);
+    return x;
+}
+
+Tensor forward_fp32(std::vector<mtf::nn::Dense>& layers, const Tensor& x) {
+    auto h = mtf::Variable(x, false);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        h = layers[i](h);
+        if (i + 1 < layers.size()) h = mtf::nn::functional::relu(h);
+    }
+    return h->value;
+}
+
+Tensor forward_int8(std::vector<mtf::nn::QuantizedDense>& layers, const Tensor& x) {
+    auto h = mtf::Variable(x, false);
+    for (auto& layer : layers) {
+        h = layer(h);
+    }
+    return h->value;
+}
+
+template <typename Fn>
+double time_ms(Fn fn) {
+    fn();
+    int iters = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        ++iters;
+        elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 300.0);
+    return elapsed / iters;
+}
+
+struct Accuracy {
+    double rel_err;     // max |y - ref| / max |ref|
+    double top1_match;  // fraction of rows with the same argmax
+};
+
+Accuracy compare(const Tensor& y, const Tensor& ref) {
+    size_t rows = ref.shape()[0];
+    size_t cols = ref.shape()[1];
+    double err = 0.0;
+    double scale = 0.0;
+    size_t same = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        size_t best_y = 0;
+        size_t best_ref = 0;
+        for (size_t j = 0; j < cols; ++j) {
+            err = std::max(err, static_cast<double>(std::fabs(y[i * cols + j] - ref[i * cols + j])));
+            scale = std::max(scale, static_cast<double>(std::fabs(ref[i * cols + j])));
+            if (y[i * cols + j] > y[i * cols + best_y]) best_y = j;
+            if (ref[i * cols + j] > ref[i * cols + best_ref]) best_ref = j;
+        }
+        same += best_y == best_ref;
+    }
+    return {err / std::max(scale, 1e-12), static_cast<double>(same) / rows};
+}
+
+int main() {
+    std::mt19937 gen(42);
+
+    std::vector<mtf::nn::Dense> layers;
+    for (size_t i = 0; i + 1 < DIMS.size(); ++i) {
+        layers.emplace_back(DIMS[i], DIMS[i + 1]);
+    }
+
+    std::vector<mtf::nn::QuantizedDense> dynamic;
+    std::vector<mtf::nn::QuantizedDense> calibrated;
+    size_t fp32_bytes = 0;
+    size_t int8_bytes = 0;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        bool relu = i + 1 < layers.size();
+        dynamic.emplace_back(layers[i], relu);
+        calibrated.emplace_back(layers[i], relu);
+        fp32_bytes += layers[i].weight()->value.size() * sizeof(float);
+        int8_bytes += dynamic.back().weights().nbytes();
+    }
+
+    // Calibrate each layer on the fp32 activations that feed it.
+    {
+        auto h = mtf::Variable(pixels(512, gen), false);
+        for (size_t i = 0; i < layers.size(); ++i) {
+            calibrated[i].calibrate(h->value);
+            h = layers[i](h);
+            if (i + 1 < layers.size()) h = mtf::nn::functional::relu(h);
+        }
+    }
+
+    std::cout << "Kernels: " << mtf::core::isa_name(mtf::core::active_isa()) << std::endl;
+    std::cout << "Weights: fp32 " << fp32_bytes / 1024 << " KiB, int8 " << int8_bytes / 1024 << " KiB" << std::endl;
+    std::cout << "batch | fp32 ms | int8 dynamic ms  speedup  rel err  top1 | int8 calibrated ms  speedup  rel err  top1"
+              << std::endl;
+
+    for (size_t batch : {1, 32, 256, 1024}) {
+        Tensor x = pixels(batch, gen);
+        Tensor ref = forward_fp32(layers, x);
+        Accuracy acc_d = compare(forward_int8(dynamic, x), ref);
+        Accuracy acc_c = compare(forward_int8(calibrated, x), ref);
+
+        double t_fp32 = time_ms([&] { forward_fp32(layers, x); });
+        double t_dyn = time_ms([&] { forward_int8(dynamic, x); });
+        double t_cal = time_ms([&] { forward_int8(calibrated, x); });
+
+        std::cout << std::setw(5) << batch << " | " << std::fixed << std::setprecision(3)
+                  << std::setw(7) << t_fp32 << " | "
+                  << std::setw(15) << t_dyn << std::setw(8) << std::setprecision(2) << t_fp32 / t_dyn << "x"
+                  << std::scientific << std::setprecision(1) << std::setw(9) << acc_d.rel_err
+                  << std::fixed << std::setprecision(3) << std::setw(6) << acc_d.top1_match << " | "
+                  << std::setw(18) << t_cal << std::setw(8) << std::setprecision(2) << t_fp32 / t_cal << "x"
+                  << std::scientific << std::setprecision(1) << std::setw(9) << acc_c.rel_err
+                  << std::fixed << std::setprecision(3) << std::setw(6) << acc_c.top1_match << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "mini_tf.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using mtf::core::Tensor;
+
+// What Tensor::randn did before: a fresh mt19937 per call, drawn serially.
+void mt19937_randn(Tensor& t, float mean, float std) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::normal_distribution<float> d(mean, std);
+    float* p = t.data();
+    for (size_t i = 0; i < t.size(); ++i) p[i] = d(gen);
+}
+
+template <typename Fn>
+double time_ms(Fn fn) {
+    fn();
+    int iters = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        ++iters;
+        elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 300.0);
+    return elapsed / iters;
+}
+
+int main() {
+    const size_t n = 4096;
+    Tensor t({n, n});
+
+    std::cout << "Kernels: " << mtf::core::isa_name(mtf::core::active_isa())
+              << ", threads: " << mtf::core::get_num_threads() << std::endl;
+
+    double old_ms = time_ms([&] { mt19937_randn(t, 0.0f, 1.0f); });
+    double new_ms = time_ms([&] { t.randn(); });
+    double rand_ms = time_ms([&] { t.rand(); });
+    double dense_ms = time_ms([&] { mtf::nn::Dense layer(n, n); });
+    std::cout << std::fixed << std::setprecision(2)
+              << n << "x" << n << " randn, mt19937:  " << std::setw(8) << old_ms << " ms" << std::endl
+              << n << "x" << n << " randn, Philox:   " << std::setw(8) << new_ms << " ms  ("
+              << old_ms / new_ms << "x)" << std::endl
+              << n << "x" << n << " rand,  Philox:   " << std::setw(8) << rand_ms << " ms" << std::endl
+              << "Dense(" << n << ", " << n << ") init:    " << std::setw(8) << dense_ms << " ms" << std::endl;
+
+    mtf::manual_seed(1234);
+    t.randn();
+    double sum = 0.0, sq = 0.0;
+    for (size_t i = 0; i < t.size(); ++i) {
+        sum += t[i];
+        sq += static_cast<double>(t[i]) * t[i];
+    }
+    double mean = sum / t.size();
+    std::cout << std::setprecision(4) << "sample mean " << mean << ", std "
+              << std::sqrt(sq / t.size() - mean * mean) << std::endl;
+
+    // The same seed gives the same numbers at any thread count.
+    const size_t threads = mtf::core::get_num_threads();
+    bool same = true;
+    for (size_t count : {size_t(1), size_t(3), size_t(8)}) {
+        mtf::core::set_num_threads(count);
+        mtf::manual_seed(1234);
+        Tensor u({n, n});
+        u.randn();
+        same = same && std::memcmp(u.data(), t.data(), t.size() * sizeof(float)) == 0;
+    }
+    mtf::core::set_num_threads(threads);
+    std::cout << "identical at 1, 3 and 8 threads: " << (same ? "yes" : "NO") << std::endl;
+    return same ? 0 : 1;
+}
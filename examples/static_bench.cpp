@@ -0,0 +1,133 @@
+#include "mini_tf.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using mtf::core::StaticTensor;
+using mtf::core::Tensor;
+
+// n-bit parity: every input pattern and whether it has an odd number of ones.
+template <size_t Bits>
+void parity_data(std::vector<float>& x, std::vector<float>& y) {
+    for (size_t i = 0; i < (size_t(1) << Bits); ++i) {
+        int ones = 0;
+        for (size_t b = 0; b < Bits; ++b) {
+            int bit = (i >> (Bits - 1 - b)) & 1;
+            ones += bit;
+            x.push_back(static_cast<float>(bit));
+        }
+        y.push_back(static_cast<float>(ones % 2));
+    }
+}
+
+template <typename Fn>
+double time_us(Fn fn) {
+    for (int i = 0; i < 100; ++i) fn();
+    int iters = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        for (int i = 0; i < 100; ++i) fn();
+        iters += 100;
+        elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 300000.0);
+    return elapsed / iters;
+}
+
+// The xor_train.cpp network, in <Bits, Hidden, 1> with tanh and sigmoid,
+// trained with plain SGD on all 2^Bits patterns, both ways from the same
+// initial weights.
+template <size_t Bits, size_t Hidden>
+void run(float learning_rate, int steps) {
+    constexpr size_t B = size_t(1) << Bits;
+    std::vector<float> x_raw, y_raw;
+    parity_data<Bits>(x_raw, y_raw);
+    Tensor x_tensor({B, Bits}, x_raw);
+    Tensor y_tensor({B, 1}, y_raw);
+
+    mtf::nn::StaticDense<Bits, Hidden> s1;
+    mtf::nn::StaticDense<Hidden, 1> s2;
+    auto sx = StaticTensor<float, B, Bits>::from_tensor(x_tensor);
+    auto sy = StaticTensor<float, B, 1>::from_tensor(y_tensor);
+
+    mtf::nn::Dense d1 = s1.to_dense();
+    mtf::nn::Dense d2 = s2.to_dense();
+    auto params = d1.parameters();
+    auto params2 = d2.parameters();
+    params.insert(params.end(), params2.begin(), params2.end());
+    mtf::optim::SGD optimizer(params, learning_rate);
+    mtf::nn::MSELoss criterion;
+    auto x = mtf::Variable(x_tensor, false);
+    auto y = mtf::Variable(y_tensor, false);
+
+    auto dynamic_forward = [&]() {
+        return mtf::nn::functional::sigmoid(d2(mtf::nn::functional::tanh(d1(x))));
+    };
+    auto dynamic_step = [&]() {
+        auto loss = criterion(dynamic_forward(), y);
+        optimizer.zero_grad();
+        mtf::autograd::Engine::backward(loss);
+        optimizer.step();
+        return loss->value[0];
+    };
+
+    auto static_forward = [&]() {
+        return mtf::core::ops::sigmoid(s2.forward(mtf::core::ops::tanh(s1.forward(sx))));
+    };
+    auto static_step = [&]() {
+        auto a1 = mtf::core::ops::tanh(s1.forward(sx));
+        auto p = mtf::core::ops::sigmoid(s2.forward(a1));
+        StaticTensor<float, B, 1> grad_p;
+        float loss = mtf::nn::functional::mse_loss(p, sy, grad_p);
+        s1.zero_grad();
+        s2.zero_grad();
+        auto grad_a1 = s2.backward(a1, mtf::nn::functional::sigmoid_backward(p, grad_p));
+        s1.backward(sx, mtf::nn::functional::tanh_backward(a1, grad_a1));
+        s1.sgd_step(learning_rate);
+        s2.sgd_step(learning_rate);
+        return loss;
+    };
+
+    float dynamic_loss = 0.0f;
+    float static_loss = 0.0f;
+    for (int i = 0; i < steps; ++i) {
+        dynamic_loss = dynamic_step();
+        static_loss = static_step();
+    }
+
+    // The trained static layers round-trip through Dense unchanged.
+    mtf::nn::StaticDense<Bits, Hidden> r1(s1.to_dense());
+    mtf::nn::StaticDense<Hidden, 1> r2(s2.to_dense());
+    auto p_static = static_forward();
+    auto p_round = mtf::core::ops::sigmoid(r2.forward(mtf::core::ops::tanh(r1.forward(sx))));
+    double round_diff = 0.0;
+    for (size_t i = 0; i < B; ++i) {
+        round_diff = std::max(round_diff, static_cast<double>(std::fabs(p_static.data[i] - p_round.data[i])));
+    }
+
+    double dyn_train = time_us(dynamic_step);
+    double sta_train = time_us(static_step);
+    double dyn_infer = time_us([&] { return dynamic_forward(); });
+    double sta_infer = time_us([&] { return static_forward(); });
+
+    std::string name = std::to_string(Bits) + "-" + std::to_string(Hidden) + "-1 x" + std::to_string(B);
+    std::cout << std::setw(12) << name << " | " << std::fixed << std::setprecision(3)
+              << std::setw(8) << dyn_train << " " << std::setw(8) << sta_train << " "
+              << std::setprecision(0) << std::setw(6) << dyn_train / sta_train << "x | "
+              << std::setprecision(3) << std::setw(8) << dyn_infer << " " << std::setw(8) << sta_infer << " "
+              << std::setprecision(0) << std::setw(6) << dyn_infer / sta_infer << "x | "
+              << std::setprecision(4) << dynamic_loss << " " << static_loss << " | "
+              << std::scientific << std::setprecision(0) << round_diff << std::endl;
+}
+
+int main() {
+    std::cout << "   model x B |        train step us       |      inference us         | loss after 2000 steps | save/load" << std::endl;
+    std::cout << "             |  dynamic   static speedup|  dynamic   static speedup| dynamic static        | max diff" << std::endl;
+    run<2, 4>(0.5f, 2000);
+    run<4, 32>(0.5f, 2000);
+    return 0;
+}
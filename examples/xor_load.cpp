@@ -48,6 +48,7 @@ void load_and_test() {
                   static_cast<int>(x_raw[2]) + static_cast<int>(x_raw[3]);
         int expected = (sum % 2 == 1) ? 1 : 0;
         
+        mtf::NoGradGuard no_grad;
         auto x_tensor = mtf::core::Tensor({1, 4}, x_raw);
         auto x = mtf::Variable(x_tensor, false);
         
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "node.hpp"
+#include <functional>
+#include <vector>
+
+namespace mtf {
+namespace optim {
+class Optimizer;
+} // namespace optim
+
+namespace autograd {
+
+// A training step whose shapes stay the same from one iteration to the next,
+// recorded once and then replayed. The first step() runs forward() with
+// recording on: every op it reaches notes how to recompute its result in place.
+// Later steps rerun those ops on the same nodes, run their backward functions
+// in the order found at capture and call the optimizer, without creating nodes
+// or result tensors.
+//
+// Inputs are the leaf nodes forward() reads, created outside it. Feed a new
+// batch by assigning to their value. When a leaf's shape differs from the one
+// captured, the next step() captures again. forward() is only called when
+// capturing, so it must not create the inputs itself or pick data up on its
+// own.
+class CapturedStep {
+public:
+    using Forward = std::function<NodePtr()>;
+
+    CapturedStep(Forward forward, optim::Optimizer& optimizer);
+
+    CapturedStep(const CapturedStep&) = delete;
+    CapturedStep& operator=(const CapturedStep&) = delete;
+
+    // Zeroes the gradients of the optimizer's parameters and of every leaf and
+    // recorded node that requires grad, runs forward and backward and steps
+    // the optimizer.
+    // Returns the loss node, which replays update in place.
+    const NodePtr& step();
+
+    // How many times forward() has been captured.
+    size_t captures() const { return captures_; }
+
+    // The step being captured on this thread, or nullptr. Ops call record() on
+    // it with their result, their inputs and a function that recomputes the
+    // result's value from the inputs' current values.
+    static CapturedStep* recording();
+    void record(NodePtr result, std::vector<NodePtr> inputs, std::function<void()> recompute);
+
+private:
+    struct Leaf {
+        Node* node;
+        core::Tensor::Shape shape;
+    };
+
+    void capture();
+    bool shapes_changed() const;
+
+    Forward forward_;
+    optim::Optimizer& optimizer_;
+    NodePtr loss_;
+    // Results and inputs of the recorded ops, which keeps them alive for the
+    // replays, and the recomputations in the order the ops ran.
+    std::vector<NodePtr> results_;
+    std::vector<NodePtr> inputs_;
+    std::vector<std::function<void()>> recompute_;
+    std::vector<Leaf> leaves_;
+    // Nodes with a backward function, children first. Their gradients are
+    // cleared before each backward pass.
+    std::vector<Node*> backward_order_;
+    size_t captures_ = 0;
+};
+
+} // namespace autograd
+} // namespace mtf
@@ -8,7 +8,20 @@ namespace autograd {
 
 class Engine {
 public:
+    // Runs the backward function of every node reachable from root, children
+    // before parents. The order is kept per thread with the graph's shape, and
+    // a later graph of the same shape reuses it without sorting.
     static void backward(NodePtr root);
+    // backward() with independent backward functions running at the same time
+    // on the shared thread pool. A node's function starts once every function
+    // that adds into its gradient has finished, and functions adding into the
+    // same gradient run one at a time in backward()'s order, so the gradients
+    // match backward() bit for bit. Kernels inside a function stay on the
+    // thread that runs it: for a graph that is one chain of large ops,
+    // backward() is faster. The schedule is reused like backward()'s order.
+    static void backward_parallel(NodePtr root);
+    // Nodes reachable from root, every node after its parents. Iterative, so
+    // deep graphs do not run out of stack.
     static std::vector<NodePtr> topological_sort(NodePtr root);
 };
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <functional>
@@ -20,6 +21,10 @@ public:
     core::Tensor grad;
     
     std::vector<NodePtr> parents;
+    // The last Engine traversal that reached this node and the node's position
+    // in its order; only the thread holding the engine's marks touches them.
+    uint64_t visit_epoch = 0;
+    uint32_t visit_index = 0;
     std::string op_name;
     
     using BackwardFn = std::function<void()>;
@@ -28,16 +33,41 @@ public:
     bool requires_grad;
 
     Node(core::Tensor val, bool req_grad = false, std::string op = "");
+    ~Node();
     
     void zero_grad();
 
     static NodePtr create(core::Tensor val, bool req_grad = false, std::string op = "");
 };
 
+// Whether ops on the calling thread record the graph for backward. They do
+// unless a NoGradGuard is alive; with one, and whenever no input requires grad,
+// an op returns a plain node: no parents, no backward function, no grad buffer.
+bool grad_enabled();
+
+// Turns graph recording off on this thread for its lifetime, for inference.
+// Guards nest; leaves created under one still get the requires_grad asked for.
+class NoGradGuard {
+public:
+    NoGradGuard();
+    ~NoGradGuard();
+
+    NoGradGuard(const NoGradGuard&) = delete;
+    NoGradGuard& operator=(const NoGradGuard&) = delete;
+
+private:
+    bool previous_;
+};
+
 NodePtr operator+(const NodePtr& a, const NodePtr& b);
 NodePtr operator-(const NodePtr& a, const NodePtr& b);
 NodePtr operator*(const NodePtr& a, const NodePtr& b);
 NodePtr matmul(const NodePtr& a, const NodePtr& b);
+// Batched matmul with the broadcasting of core::ops::bmm; a broadcast operand
+// gets the sum of its gradients over the batch.
+NodePtr bmm(const NodePtr& a, const NodePtr& b);
+// input * weight + bias in a single node; bias is a [1, N] row or nullptr.
+NodePtr linear(const NodePtr& input, const NodePtr& weight, const NodePtr& bias = nullptr);
 
 } // namespace autograd
 } // namespace mtf
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace mtf {
+namespace core {
+
+// Scoped bump allocator for per-step temporaries. While a StepArena is alive on
+// a thread, tensor storage and autograd nodes created on that thread are carved
+// out of a reusable region; when the outermost scope ends the whole region is
+// rewound in O(1) and reused by the next scope.
+//
+// Create parameters and optimizer state before entering the scope. Anything that
+// does outlive the scope stays valid: its chunk is retired instead of rewound
+// and freed once the last allocation in it is released.
+class StepArena {
+public:
+    StepArena();
+    ~StepArena();
+
+    StepArena(const StepArena&) = delete;
+    StepArena& operator=(const StepArena&) = delete;
+
+    static bool active();
+
+    // Allocates 64-byte aligned memory from the calling thread's arena; only
+    // valid while active(). The memory may be released from any thread.
+    static void* allocate(size_t bytes);
+    static void deallocate(void* ptr);
+
+    // Bytes reserved by the calling thread's arena region.
+    static size_t reserved_bytes();
+};
+
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(StepArena::allocate(n * sizeof(T)));
+    }
+    void deallocate(T* ptr, size_t) {
+        StepArena::deallocate(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>&) const { return false; }
+};
+
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "tensor.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <initializer_list>
+
+namespace mtf {
+namespace core {
+
+// NumPy-style result shape of broadcasting a against b. Throws
+// std::invalid_argument when the shapes are incompatible.
+Tensor::Shape broadcast_shapes(const Tensor::Shape& a, const Tensor::Shape& b);
+
+// Strides that read a tensor of `shape`/`strides` as if it had been broadcast to
+// `target`: dimensions are right-aligned and broadcast ones get stride 0.
+Tensor::Strides broadcast_strides(const Tensor::Shape& shape, const Tensor::Strides& strides,
+                                  const Tensor::Shape& target);
+
+// Loop nest that walks up to MAX_OPERANDS strided operands over one common shape.
+// Size-1 dimensions are dropped and neighbouring dimensions that are contiguous in
+// every operand are merged, so the innermost run is as long as possible and, when
+// each operand's inner stride is 0 or 1, the caller's inner loop vectorizes.
+class BroadcastLoop {
+public:
+    static constexpr size_t MAX_OPERANDS = 4;
+
+    BroadcastLoop(const Tensor::Shape& shape, std::initializer_list<Tensor::Strides> strides);
+
+    size_t size() const { return size_; }
+    size_t inner_size() const { return shape_.back(); }
+    size_t inner_stride(size_t operand) const { return strides_[operand].back(); }
+
+    // Calls fn(offsets, count) for every run of the linear element range
+    // [begin, end) that stays within one innermost row. offsets[k] is the element
+    // offset of operand k at the start of the run.
+    template <typename Fn>
+    void for_each_run(size_t begin, size_t end, Fn&& fn) const {
+        if (begin >= end) return;
+
+        size_t inner = inner_size();
+        size_t row = begin / inner;
+        size_t col = begin % inner;
+        std::array<size_t, MAX_OPERANDS> offsets;
+
+        while (begin < end) {
+            row_offsets(row, offsets.data());
+            for (size_t k = 0; k < num_operands_; ++k) {
+                offsets[k] += col * strides_[k].back();
+            }
+            size_t count = std::min(inner - col, end - begin);
+            fn(offsets.data(), count);
+            begin += count;
+            ++row;
+            col = 0;
+        }
+    }
+
+private:
+    void row_offsets(size_t row, size_t* offsets) const;
+
+    Tensor::Shape shape_;
+    std::array<Tensor::Strides, MAX_OPERANDS> strides_;
+    size_t num_operands_;
+    size_t size_;
+};
+
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,38 @@
+#pragma once
+
+namespace mtf {
+namespace core {
+
+// Instruction set levels the kernels are built for, in increasing order.
+enum class Isa {
+    Generic,  // baseline of the compiler target (SSE2 on x86-64)
+    SSE42,
+    AVX2,     // AVX2 + FMA + F16C
+    AVX512    // AVX-512F/BW + AVX2 + FMA + F16C
+};
+
+struct CpuFeatures {
+    bool sse42 = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool os_ymm = false;  // the OS saves the AVX register state
+    bool os_zmm = false;  // the OS saves the AVX-512 register state
+};
+
+// Queried with cpuid once, on first use.
+const CpuFeatures& cpu_features();
+
+// Best level this CPU and this build support.
+Isa detected_isa();
+
+// Level the kernels dispatch to: detected_isa(), or a lower one requested
+// through MTF_CPU_ISA (generic, sse4.2, avx2 or avx512) for testing.
+Isa active_isa();
+
+const char* isa_name(Isa isa);
+
+} // namespace core
+} // namespace mtf
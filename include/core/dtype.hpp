@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mtf {
+namespace core {
+
+// Element types a Tensor can store. Arithmetic is always done in float32:
+// 16-bit data is widened when read and rounded to nearest even when written.
+// The values are part of the file format written by Tensor::save.
+enum class DType : uint32_t {
+    Float32 = 0,
+    BFloat16 = 1,  // upper half of a float32: same range, 8-bit mantissa
+    Float16 = 2    // IEEE binary16: 5-bit exponent, 10-bit mantissa
+};
+
+inline size_t dtype_size(DType dtype) {
+    return dtype == DType::Float32 ? 4 : 2;
+}
+
+inline const char* dtype_name(DType dtype) {
+    switch (dtype) {
+        case DType::Float32: return "float32";
+        case DType::BFloat16: return "bfloat16";
+        case DType::Float16: return "float16";
+    }
+    return "unknown";
+}
+
+} // namespace core
+} // namespace mtf
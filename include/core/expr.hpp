@@ -0,0 +1,285 @@
+#pragma once
+
+#include "broadcast.hpp"
+#include "tensor.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace mtf {
+namespace core {
+
+// Lazy elementwise expressions. Building one only records the operations;
+// converting it to a Tensor (or lazy::assign) evaluates the whole chain in a
+// single fused loop, so
+//
+//     Tensor y = lazy::mul_scalar(lazy::add(lazy::mul(a, b), c), k);
+//
+// reads a, b and c once and writes y once, where the eager ops::* version makes
+// three passes and allocates two temporaries. Operands broadcast like the eager
+// ops and may be strided views.
+//
+// Expressions refer to their tensors without owning them: evaluate them in the
+// statement that builds them rather than keeping them in an `auto` variable.
+namespace expr {
+
+// Elements per task, as for the eager elementwise ops.
+constexpr size_t EVAL_GRAIN = 32768;
+
+template <typename E>
+struct Expr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+// Every expression node provides:
+//   shape()          broadcast shape of its result
+//   flat(shape)      true when each leaf is contiguous with exactly `shape`
+//   flat_at(i)       element i, valid when flat(shape)
+//   bind(shape)      prepares leaves to be read broadcast to `shape`
+//   cursor()         per-thread reader: set_row(idx, outer_dims) positions it at
+//                    the row with outer index idx, at(j) reads column j
+
+class Ref : public Expr<Ref> {
+public:
+    explicit Ref(const Tensor& t) : t_(&t), data_(t.data()) {}
+
+    Tensor::Shape shape() const { return t_->shape(); }
+    bool flat(const Tensor::Shape& shape) const {
+        return t_->is_contiguous() && t_->shape() == shape;
+    }
+    float flat_at(size_t i) const { return data_[i]; }
+    void bind(const Tensor::Shape& shape) const {
+        strides_ = broadcast_strides(t_->shape(), t_->strides(), shape);
+    }
+
+    struct Cursor {
+        const float* base;
+        const size_t* strides;
+        size_t inc;
+        const float* row;
+
+        void set_row(const size_t* idx, size_t outer_dims) {
+            size_t offset = 0;
+            for (size_t d = 0; d < outer_dims; ++d) offset += idx[d] * strides[d];
+            row = base + offset;
+        }
+        float at(size_t j) const { return row[j * inc]; }
+    };
+    Cursor cursor() const {
+        return {data_, strides_.data(), strides_.empty() ? 0 : strides_.back(), data_};
+    }
+
+private:
+    const Tensor* t_;
+    const float* data_;
+    mutable Tensor::Strides strides_;
+};
+
+template <typename Op, typename L, typename R>
+class Binary : public Expr<Binary<Op, L, R>> {
+public:
+    Binary(const L& l, const R& r) : l_(l), r_(r) {}
+
+    Tensor::Shape shape() const { return broadcast_shapes(l_.shape(), r_.shape()); }
+    bool flat(const Tensor::Shape& shape) const { return l_.flat(shape) && r_.flat(shape); }
+    float flat_at(size_t i) const { return Op()(l_.flat_at(i), r_.flat_at(i)); }
+    void bind(const Tensor::Shape& shape) const {
+        l_.bind(shape);
+        r_.bind(shape);
+    }
+
+    struct Cursor {
+        typename L::Cursor l;
+        typename R::Cursor r;
+
+        void set_row(const size_t* idx, size_t outer_dims) {
+            l.set_row(idx, outer_dims);
+            r.set_row(idx, outer_dims);
+        }
+        float at(size_t j) const { return Op()(l.at(j), r.at(j)); }
+    };
+    Cursor cursor() const { return {l_.cursor(), r_.cursor()}; }
+
+private:
+    L l_;
+    R r_;
+};
+
+template <typename Op, typename E>
+class WithScalar : public Expr<WithScalar<Op, E>> {
+public:
+    WithScalar(const E& e, float s) : e_(e), s_(s) {}
+
+    Tensor::Shape shape() const { return e_.shape(); }
+    bool flat(const Tensor::Shape& shape) const { return e_.flat(shape); }
+    float flat_at(size_t i) const { return Op()(e_.flat_at(i), s_); }
+    void bind(const Tensor::Shape& shape) const { e_.bind(shape); }
+
+    struct Cursor {
+        typename E::Cursor e;
+        float s;
+
+        void set_row(const size_t* idx, size_t outer_dims) { e.set_row(idx, outer_dims); }
+        float at(size_t j) const { return Op()(e.at(j), s); }
+    };
+    Cursor cursor() const { return {e_.cursor(), s_}; }
+
+private:
+    E e_;
+    float s_;
+};
+
+struct AddOp { float operator()(float x, float y) const { return x + y; } };
+struct SubOp { float operator()(float x, float y) const { return x - y; } };
+struct MulOp { float operator()(float x, float y) const { return x * y; } };
+struct DivOp { float operator()(float x, float y) const { return x / y; } };
+struct MaxOp { float operator()(float x, float y) const { return x < y ? y : x; } };
+struct RSubOp { float operator()(float x, float s) const { return s - x; } };
+struct RDivOp { float operator()(float x, float s) const { return s / x; } };
+// Same NaN behaviour as ops::relu.
+struct ReluOp { float operator()(float x, float s) const { return s < x ? x : s; } };
+
+inline Ref operand(const Tensor& t) { return Ref(t); }
+template <typename E>
+const E& operand(const Expr<E>& e) { return e.self(); }
+
+template <typename T>
+using operand_t = typename std::decay<decltype(operand(std::declval<const T&>()))>::type;
+
+template <typename Op, typename A, typename B>
+Binary<Op, operand_t<A>, operand_t<B>> make_binary(const A& a, const B& b) {
+    return {operand(a), operand(b)};
+}
+
+template <typename Op, typename A>
+WithScalar<Op, operand_t<A>> make_scalar(const A& a, float s) {
+    return {operand(a), s};
+}
+
+// Writes e, broadcast to `shape`, into the contiguous buffer out.
+template <typename E>
+void evaluate(const E& e, const Tensor::Shape& shape, float* out) {
+    size_t n = 1;
+    for (size_t dim : shape) n *= dim;
+    if (n == 0) return;
+
+    if (e.flat(shape)) {
+        parallel_for(0, n, EVAL_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) out[i] = e.flat_at(i);
+        });
+        return;
+    }
+
+    e.bind(shape);
+    const size_t outer_dims = shape.empty() ? 0 : shape.size() - 1;
+    const size_t inner = shape.empty() ? 1 : shape.back();
+    const size_t rows = n / inner;
+    parallel_for(0, rows, std::max<size_t>(1, EVAL_GRAIN / inner), [&](size_t begin, size_t end) {
+        auto cursor = e.cursor();
+        Tensor::Shape idx(outer_dims + 1, 0);
+        for (size_t r = begin; r < end; ++r) {
+            size_t rem = r;
+            for (size_t d = outer_dims; d-- > 0;) {
+                idx[d] = rem % shape[d];
+                rem /= shape[d];
+            }
+            cursor.set_row(idx.data(), outer_dims);
+            float* dst = out + r * inner;
+            for (size_t j = 0; j < inner; ++j) dst[j] = cursor.at(j);
+        }
+    });
+}
+
+#define MTF_EXPR_OPERATOR(op, Op)                                                      \
+    template <typename L, typename R>                                                  \
+    Binary<Op, L, R> operator op(const Expr<L>& l, const Expr<R>& r) {                 \
+        return {l.self(), r.self()};                                                   \
+    }                                                                                  \
+    template <typename L>                                                              \
+    Binary<Op, L, Ref> operator op(const Expr<L>& l, const Tensor& r) {                \
+        return {l.self(), Ref(r)};                                                     \
+    }                                                                                  \
+    template <typename R>                                                              \
+    Binary<Op, Ref, R> operator op(const Tensor& l, const Expr<R>& r) {                \
+        return {Ref(l), r.self()};                                                     \
+    }
+
+MTF_EXPR_OPERATOR(+, AddOp)
+MTF_EXPR_OPERATOR(-, SubOp)
+MTF_EXPR_OPERATOR(*, MulOp)
+MTF_EXPR_OPERATOR(/, DivOp)
+
+#undef MTF_EXPR_OPERATOR
+
+template <typename E>
+WithScalar<AddOp, E> operator+(const Expr<E>& e, float s) { return {e.self(), s}; }
+template <typename E>
+WithScalar<AddOp, E> operator+(float s, const Expr<E>& e) { return {e.self(), s}; }
+template <typename E>
+WithScalar<SubOp, E> operator-(const Expr<E>& e, float s) { return {e.self(), s}; }
+template <typename E>
+WithScalar<RSubOp, E> operator-(float s, const Expr<E>& e) { return {e.self(), s}; }
+template <typename E>
+WithScalar<MulOp, E> operator*(const Expr<E>& e, float s) { return {e.self(), s}; }
+template <typename E>
+WithScalar<MulOp, E> operator*(float s, const Expr<E>& e) { return {e.self(), s}; }
+template <typename E>
+WithScalar<DivOp, E> operator/(const Expr<E>& e, float s) { return {e.self(), s}; }
+template <typename E>
+WithScalar<RDivOp, E> operator/(float s, const Expr<E>& e) { return {e.self(), s}; }
+template <typename E>
+WithScalar<MulOp, E> operator-(const Expr<E>& e) { return {e.self(), -1.0f}; }
+
+} // namespace expr
+
+// Lazy counterparts of the ops:: elementwise functions. Arguments may be
+// tensors or other lazy expressions.
+namespace lazy {
+
+inline expr::Ref ref(const Tensor& t) { return expr::Ref(t); }
+
+template <typename A, typename B>
+auto add(const A& a, const B& b) { return expr::make_binary<expr::AddOp>(a, b); }
+template <typename A, typename B>
+auto sub(const A& a, const B& b) { return expr::make_binary<expr::SubOp>(a, b); }
+template <typename A, typename B>
+auto mul(const A& a, const B& b) { return expr::make_binary<expr::MulOp>(a, b); }
+template <typename A, typename B>
+auto div(const A& a, const B& b) { return expr::make_binary<expr::DivOp>(a, b); }
+template <typename A, typename B>
+auto max(const A& a, const B& b) { return expr::make_binary<expr::MaxOp>(a, b); }
+
+template <typename A>
+auto add_scalar(const A& a, float s) { return expr::make_scalar<expr::AddOp>(a, s); }
+template <typename A>
+auto mul_scalar(const A& a, float s) { return expr::make_scalar<expr::MulOp>(a, s); }
+template <typename A>
+auto relu(const A& a) { return expr::make_scalar<expr::ReluOp>(a, 0.0f); }
+
+// Evaluates e into out in place. out must be contiguous with the result shape.
+// out may also appear in e, but only as itself, not through a different view.
+template <typename E>
+void assign(Tensor& out, const expr::Expr<E>& e) {
+    Tensor::Shape shape = e.self().shape();
+    if (!out.is_contiguous() || out.shape() != shape) {
+        throw std::invalid_argument("lazy::assign: output must be contiguous with the result shape");
+    }
+    expr::evaluate(e.self(), shape, out.data());
+}
+
+} // namespace lazy
+
+template <typename E>
+Tensor::Tensor(const expr::Expr<E>& e) : Tensor(e.self().shape()) {
+    expr::evaluate(e.self(), shape_, data());
+}
+
+template <typename E>
+Tensor& Tensor::operator=(const expr::Expr<E>& e) {
+    return *this = Tensor(e);
+}
+
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "dtype.hpp"
+#include <cstddef>
+#include <memory>
+
+namespace mtf {
+namespace core {
+
+// C[M,N] = alpha * op(A)[M,K] * op(B)[K,N] + beta * C, all row-major, where
+// op(X) is X or X^T. Transposed operands are read in place, never copied.
+// When beta == 0 the previous contents of C are never read.
+void sgemm(bool trans_a, bool trans_b,
+           size_t M, size_t N, size_t K,
+           float alpha,
+           const float* A, size_t lda,
+           const float* B, size_t ldb,
+           float beta,
+           float* C, size_t ldc);
+
+// Same product with arbitrary element strides: op(A)(i, p) is A[i * rs_a + p * cs_a]
+// and likewise for B. C rows are ldc apart with unit column stride.
+void sgemm_strided(size_t M, size_t N, size_t K,
+                   float alpha,
+                   const float* A, size_t rs_a, size_t cs_a,
+                   const float* B, size_t rs_b, size_t cs_b,
+                   float beta,
+                   float* C, size_t ldc);
+
+// sgemm_strided with A and B stored as any DType. 16-bit operands are widened
+// to float32 while they are packed, so products accumulate in float32.
+void gemm_strided(size_t M, size_t N, size_t K,
+                  float alpha,
+                  const void* A, DType a_type, size_t rs_a, size_t cs_a,
+                  const void* B, DType b_type, size_t rs_b, size_t cs_b,
+                  float beta,
+                  float* C, size_t ldc);
+
+// `batch` independent products C_p = alpha * A_p * B_p + beta * C_p, p < batch,
+// where A_p is the matrix at A + p * bs_a elements with gemm_strided's element
+// strides, and likewise for B_p and C_p. A batch stride of 0 uses the same
+// matrix for every p; C_p must not overlap. Tiles of all products are spread
+// across threads together.
+void gemm_batched(size_t batch, size_t M, size_t N, size_t K,
+                  float alpha,
+                  const void* A, DType a_type, size_t bs_a, size_t rs_a, size_t cs_a,
+                  const void* B, DType b_type, size_t bs_b, size_t rs_b, size_t cs_b,
+                  float beta,
+                  float* C, size_t bs_c, size_t ldc);
+
+// The right-hand operand B[K,N] of a product, packed once into the panel layout
+// the GEMM kernels read, for weights multiplied by many different A. Packing
+// widens 16-bit B to float32. The buffer is ordinary heap memory, never the
+// step arena, and copies share it.
+class PackedMatrix {
+public:
+    PackedMatrix() = default;
+    // Element (p, j) of B is at B[p * rs + j * cs].
+    PackedMatrix(size_t K, size_t N, const void* B, DType dtype, size_t rs, size_t cs);
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    bool empty() const { return !data_; }
+    size_t nbytes() const;
+
+    // Rows [p, p + kc) of columns [j, j + GEMM_NR) start at data() + p * ld() + j * kc.
+    const float* data() const { return data_.get(); }
+    size_t ld() const { return ld_; }
+
+private:
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    size_t ld_ = 0;
+    std::shared_ptr<float> data_;
+};
+
+// gemm_strided with B taken from a PackedMatrix, so no packing of B happens.
+void gemm_prepacked(size_t M, size_t N, size_t K,
+                    float alpha,
+                    const void* A, DType a_type, size_t rs_a, size_t cs_a,
+                    const PackedMatrix& B,
+                    float beta,
+                    float* C, size_t ldc);
+
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "cpu.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+// Register tile of the GEMM microkernels. Packed A slivers hold GEMM_MR rows,
+// packed B slivers hold GEMM_NR columns, both laid out k-major.
+constexpr size_t GEMM_MR = 6;
+constexpr size_t GEMM_NR = 16;
+
+// c[GEMM_MR, GEMM_NR] (row stride rs_c) = alpha * a * b + beta * c
+using GemmMicroKernel = void (*)(size_t kc, const float* a, const float* b,
+                                 float* c, size_t rs_c, float alpha, float beta);
+
+// Register tile of the int8 GEMM microkernels.
+constexpr size_t QGEMM_MR = 4;
+constexpr size_t QGEMM_NR = 16;
+
+// c[mr, QGEMM_NR] (row stride ldc) = a[mr, 2 * kpairs] * b in exact int32
+// arithmetic, for mr <= QGEMM_MR. Rows of a hold int8 values widened to int16,
+// lda apart. b is one packed panel: for each pair of k, QGEMM_NR columns of two
+// int8 values (even k, odd k).
+using QGemmMicroKernel = void (*)(size_t mr, size_t kpairs, const int16_t* a, size_t lda,
+                                  const int8_t* b, int32_t* c, size_t ldc);
+
+// y[j] += sum over k < K of x[k] * w[k * ldw + j], for j < n.
+using GemvKernel = void (*)(size_t K, size_t n, const float* x, const float* w, size_t ldw, float* y);
+
+// y[i] = f(x[i]) for i < n; x and y may alias.
+using UnaryKernel = void (*)(const float* x, float* y, size_t n);
+
+// y[i] = f(x[i * incx], s) for i < n.
+using ScalarKernel = void (*)(const float* x, size_t incx, float s, float* y, size_t n);
+
+// y[i] = f(a[i * inca], b[i * incb]) for i < n. An increment of 0 repeats one value.
+using BinaryKernel = void (*)(const float* a, size_t inca, const float* b, size_t incb,
+                              float* y, size_t n);
+
+// y[i] += alpha * x[i * incx] for i < n.
+using AxpyKernel = void (*)(float alpha, const float* x, size_t incx, float* y, size_t n);
+
+// y[i] += alpha * a[i * inca] * b[i * incb] for i < n. An increment of 0
+// repeats one value.
+using AddcmulKernel = void (*)(float alpha, const float* a, size_t inca, const float* b, size_t incb,
+                               float* y, size_t n);
+
+// y[i] = x[i] widened from a 16-bit format to float32, which is exact.
+using WidenKernel = void (*)(const uint16_t* x, float* y, size_t n);
+
+// y[i] = x[i] rounded to nearest even in a 16-bit format. NaNs stay NaN.
+using NarrowKernel = void (*)(const float* x, uint16_t* y, size_t n);
+
+// Reduces x[0..n) to one value. The order of operations is fixed, so every
+// implementation gives the same result.
+using ReduceKernel = float (*)(const float* x, size_t n);
+
+// Philox4x32-10 output for the counters first .. first + blocks - 1 under the
+// key (k0, k1), four words per counter in counter order.
+using PhiloxKernel = void (*)(uint64_t first, size_t blocks, uint32_t k0, uint32_t k1, uint32_t* out);
+
+// Box-Muller transform: for each pair p of uniform words (words[2p], words[2p+1])
+// with log_u1[p] the log of the first as a value in (0, 1], writes the two
+// normal samples out[2p] and out[2p+1].
+using BoxMullerKernel = void (*)(const uint32_t* words, const float* log_u1, size_t pairs, float* out);
+
+struct KernelTable {
+    Isa isa;
+
+    GemmMicroKernel sgemm_ukernel;
+    QGemmMicroKernel qgemm_ukernel;
+    GemvKernel sgemv;
+
+    UnaryKernel exp;
+    UnaryKernel log;
+    UnaryKernel tanh;
+    UnaryKernel sigmoid;
+
+    ScalarKernel add_scalar;
+    ScalarKernel mul_scalar;
+    ScalarKernel max_scalar;
+
+    BinaryKernel add;
+    BinaryKernel sub;
+    BinaryKernel mul;
+    BinaryKernel div;
+    BinaryKernel max;
+
+    AxpyKernel axpy;
+    AddcmulKernel addcmul;
+
+    ReduceKernel sum;         // pairwise
+    ReduceKernel max_reduce;  // NaN if any element is NaN, -inf when n == 0
+
+    PhiloxKernel philox;
+    BoxMullerKernel box_muller;
+
+    WidenKernel bf16_to_float;
+    NarrowKernel float_to_bf16;
+    WidenKernel fp16_to_float;
+    NarrowKernel float_to_fp16;
+};
+
+// Kernels for active_isa(), chosen once on first use.
+const KernelTable& table();
+
+// Each fills in the kernels built for its instruction set, on top of the ones
+// already in the table. Only the levels the compiler can target are built.
+void init_generic_kernels(KernelTable& table);
+void init_sse42_kernels(KernelTable& table);
+void init_avx2_kernels(KernelTable& table);
+void init_avx512_kernels(KernelTable& table);
+
+void sgemm_ukernel_avx2(size_t kc, const float* a, const float* b,
+                        float* c, size_t rs_c, float alpha, float beta);
+void sgemm_ukernel_avx512(size_t kc, const float* a, const float* b,
+                          float* c, size_t rs_c, float alpha, float beta);
+
+void sgemv_avx2(size_t K, size_t n, const float* x, const float* w, size_t ldw, float* y);
+void sgemv_avx512(size_t K, size_t n, const float* x, const float* w, size_t ldw, float* y);
+
+void qgemm_ukernel_avx2(size_t mr, size_t kpairs, const int16_t* a, size_t lda,
+                        const int8_t* b, int32_t* c, size_t ldc);
+void qgemm_ukernel_avx512(size_t mr, size_t kpairs, const int16_t* a, size_t lda,
+                          const int8_t* b, int32_t* c, size_t ldc);
+
+void vexp_avx2(const float* x, float* y, size_t n);
+void vlog_avx2(const float* x, float* y, size_t n);
+void vtanh_avx2(const float* x, float* y, size_t n);
+void vsigmoid_avx2(const float* x, float* y, size_t n);
+
+void bf16_to_float_avx2(const uint16_t* x, float* y, size_t n);
+void float_to_bf16_avx2(const float* x, uint16_t* y, size_t n);
+void fp16_to_float_avx2(const uint16_t* x, float* y, size_t n);
+void float_to_fp16_avx2(const float* x, uint16_t* y, size_t n);
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
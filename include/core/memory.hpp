@@ -7,8 +7,58 @@
 namespace mtf {
 namespace core {
 
+// Tensor buffers come from a caching allocator: freed blocks go to per-thread
+// free lists bucketed by size class and are handed out again before the system
+// allocator is asked for more. Requests larger than the biggest size class or
+// with alignment above 64 bytes bypass the cache.
 void* aligned_alloc(size_t size, size_t alignment = 64);
 void aligned_free(void* ptr);
 
+struct AllocatorStats {
+    size_t hits;              // allocations served from a free list
+    size_t misses;            // allocations that went to the system allocator
+    size_t system_frees;      // blocks returned to the system allocator
+    size_t bytes_in_use;      // bytes handed out and not yet freed
+    size_t peak_bytes_in_use;
+    size_t bytes_cached;      // bytes sitting in free lists
+    size_t cache_limit;
+};
+
+AllocatorStats allocator_stats();
+// Resets the hit/miss/free counters and sets the peak to the current usage.
+void reset_allocator_stats();
+
+// Returns every cached block of every thread to the system allocator.
+void empty_cache();
+// Upper bound on bytes kept in free lists across all threads. Defaults to
+// MTF_CACHE_LIMIT_MB megabytes when set, otherwise 1 GiB. Zero disables caching.
+void set_cache_limit(size_t bytes);
+
+// On Linux, blocks of at least this many bytes are mapped straight from the
+// system on 2 MiB boundaries and advised to use transparent huge pages, so GEMM
+// operands and activations take far fewer TLB entries. They are cached like any
+// other block. Defaults to MTF_HUGEPAGE_MB megabytes when set, otherwise 2 MiB.
+// Zero disables mapping.
+void set_hugepage_threshold(size_t bytes);
+size_t hugepage_threshold();
+
+// Where the pages of mapped blocks go on multi-socket hosts. Every policy but
+// Default faults the pages in when the block is mapped, instead of leaving that
+// to whichever thread writes first; all but Bind split that over the thread
+// pool.
+enum class NumaPolicy {
+    Default,     // the kernel's own first-touch placement
+    FirstTouch,  // each pool worker touches its share, so pages follow the workers
+    Interleave,  // pages alternate across all online nodes
+    Bind,        // pages stay on the node the allocating (calling) thread runs
+                 // on, whichever nodes the pool workers run on; the caller
+                 // touches them itself
+};
+
+// Defaults to MTF_NUMA (default, first_touch, interleave or bind) when set.
+// Applies to blocks mapped afterwards; call empty_cache() to drop cached ones.
+void set_numa_policy(NumaPolicy policy);
+NumaPolicy numa_policy();
+
 } // namespace core
 } // namespace mtf
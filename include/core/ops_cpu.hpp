@@ -1,11 +1,17 @@
 #pragma once
 
+#include "gemm.hpp"
 #include "tensor.hpp"
+#include <vector>
 
 namespace mtf {
 namespace core {
 namespace ops {
 
+// Elementwise ops accept strided views and always return contiguous tensors.
+// Binary ones broadcast their operands NumPy-style. bfloat16 and float16
+// inputs are computed in float32 and the result keeps the input dtype, or is
+// float32 when the two inputs differ.
 Tensor add(const Tensor& a, const Tensor& b);
 Tensor sub(const Tensor& a, const Tensor& b);
 Tensor mul(const Tensor& a, const Tensor& b);
@@ -14,15 +20,94 @@ Tensor div(const Tensor& a, const Tensor& b);
 Tensor add_scalar(const Tensor& a, float scalar);
 Tensor mul_scalar(const Tensor& a, float scalar);
 
+// The same ops writing into out, which must be contiguous and already have the
+// result shape; its dtype is kept. out may be one of the operands. Nothing is
+// allocated when all tensors are float32. Throw std::invalid_argument when out
+// does not fit.
+void add(const Tensor& a, const Tensor& b, Tensor& out);
+void sub(const Tensor& a, const Tensor& b, Tensor& out);
+void mul(const Tensor& a, const Tensor& b, Tensor& out);
+void div(const Tensor& a, const Tensor& b, Tensor& out);
+void mul_scalar(const Tensor& a, float scalar, Tensor& out);
+
+// In place on a, which must be contiguous; b broadcasts to the shape of a.
+void add_(Tensor& a, const Tensor& b);
+void sub_(Tensor& a, const Tensor& b);
+void mul_(Tensor& a, const Tensor& b);
+void mul_scalar_(Tensor& a, float scalar);
+// y += alpha * x, and out += alpha * a * b, with the right-hand operands
+// broadcast to the contiguous destination. For accumulating gradients.
+void axpy(float alpha, const Tensor& x, Tensor& y);
+void addcmul_(Tensor& out, const Tensor& a, const Tensor& b, float alpha = 1.0f);
+
+// a and b may be of any dtype; products accumulate in float32 and c is float32.
 Tensor matmul(const Tensor& a, const Tensor& b);
+// c = alpha * op(a) * op(b) + beta * c, op(x) = trans ? x^T : x. c must already
+// have the result shape; with beta == 1 the product is accumulated into it.
+// matmul() and the gemm() overloads throw std::invalid_argument when an operand
+// is not 2-D, the inner dimensions differ, or c is not float32 [M, N] with
+// contiguous rows.
+void gemm(bool trans_a, bool trans_b, float alpha,
+          const Tensor& a, const Tensor& b, float beta, Tensor& c);
+// Batched matmul: a [B, M, K] times b [B, K, N] gives [B, M, N]. An operand
+// that is 2-D or has a batch of 1 is broadcast across the other's batch.
+// Throws std::invalid_argument when the shapes do not fit.
+Tensor bmm(const Tensor& a, const Tensor& b);
+// c[p] = alpha * op(a[p]) * op(b[p]) + beta * c[p] for every p of the
+// broadcast batch. When c is 2-D or has a batch of 1 while the batch is larger,
+// the products of all p are summed into it instead, as the gradient of a
+// broadcast operand needs.
+void gemm_batched(bool trans_a, bool trans_b, float alpha,
+                  const Tensor& a, const Tensor& b, float beta, Tensor& c);
+// op(b) packed once, for repeated gemm() calls with it on the right.
+PackedMatrix pack_gemm_rhs(const Tensor& b, bool trans_b = false);
+void gemm(bool trans_a, float alpha, const Tensor& a, const PackedMatrix& b, float beta, Tensor& c);
+// Activations that can be fused into the output of a layer.
+enum class Activation { None, Relu, Sigmoid, Tanh };
+
+// y[1, N] = act(x[1, K] * w[K, N] + bias) for a single input row. Skips the
+// packing a GEMM does: rows of w stream through a vectorized matrix-vector
+// kernel, split across threads by output columns when w is large. bias is [N]
+// or [1, N] and may be empty.
+Tensor linear_row(const Tensor& x, const Tensor& w, const Tensor& bias,
+                  Activation act = Activation::None);
+// a = act(a) in place; a must be contiguous float32.
+void apply_activation(Tensor& a, Activation act);
+
+// Zero-copy: returns a strided view of a with the two dimensions swapped.
 Tensor transpose(const Tensor& a);
 
+// Reductions over `axes`, which may be negative to count from the end; an empty
+// list reduces over every axis. Reduced axes are dropped unless keepdim is set,
+// in which case they stay with size 1, and a result with no axes left has shape
+// {1}. Sums are pairwise, and large inputs are split across threads with a fixed
+// blocking, so results do not depend on the thread count. Results are float32.
 Tensor sum(const Tensor& a);
 Tensor mean(const Tensor& a);
+Tensor sum(const Tensor& a, const std::vector<int>& axes, bool keepdim = false);
+Tensor mean(const Tensor& a, const std::vector<int>& axes, bool keepdim = false);
+// The same into out, which must be contiguous float32 with the result shape.
+// Nothing is allocated for a contiguous float32 a reduced over one run of
+// neighbouring axes.
+void sum(const Tensor& a, const std::vector<int>& axes, bool keepdim, Tensor& out);
+void mean(const Tensor& a, const std::vector<int>& axes, bool keepdim, Tensor& out);
+// mean() and max() throw std::invalid_argument when a reduced dimension is
+// empty. max() is NaN wherever one of the reduced elements is NaN.
+Tensor max(const Tensor& a, const std::vector<int>& axes, bool keepdim = false);
+// Index of the first maximum along `axis`, stored as float.
+Tensor argmax(const Tensor& a, int axis, bool keepdim = false);
+// Sums a gradient of a broadcast result back down to the shape of the operand
+// that was broadcast.
+Tensor reduce_to_shape(const Tensor& grad, const Tensor::Shape& shape);
+void reduce_to_shape(const Tensor& grad, const Tensor::Shape& shape, Tensor& out);
 
 Tensor relu(const Tensor& a);
 Tensor sigmoid(const Tensor& a);
 Tensor tanh(const Tensor& a);
+// The same into a contiguous out of a's shape, like the binary ops above.
+void relu(const Tensor& a, Tensor& out);
+void sigmoid(const Tensor& a, Tensor& out);
+void tanh(const Tensor& a, Tensor& out);
 Tensor exp(const Tensor& a);
 Tensor log(const Tensor& a);
 Tensor max(const Tensor& a, const Tensor& b);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "tensor.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace mtf {
+namespace core {
+namespace quant {
+
+// Symmetric int8 quantization: x is stored as q = round(x / scale) clamped to
+// [-127, 127], so x ~= scale * q and zero stays exact. NaN is stored as 0.
+
+// Scale mapping the largest |x[i]| to 127, or 1 when x is all zeros.
+float absmax_scale(const float* x, size_t n);
+
+// Weights w[K, N] of a product x * w, quantized with one scale per output
+// column and packed in panels for the int8 GEMM kernels.
+class Int8Weights {
+public:
+    Int8Weights() = default;
+    explicit Int8Weights(const Tensor& weight);
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    const std::vector<float>& scales() const { return scales_; }
+    size_t nbytes() const { return packed_.size() + scales_.size() * sizeof(float); }
+
+    // Panel holding columns [p * QGEMM_NR, (p + 1) * QGEMM_NR).
+    const int8_t* panel(size_t p) const { return packed_.data() + p * panel_size_; }
+    size_t kpairs() const { return kpairs_; }
+
+    // The quantized weights as float32, for checking the error.
+    Tensor dequantize() const;
+
+private:
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    size_t kpairs_ = 0;
+    size_t panel_size_ = 0;
+    std::vector<float> scales_;
+    std::vector<int8_t> packed_;
+};
+
+// y[M, N] = x * w + bias, then ReLU when relu is set. x is quantized with
+// x_scale, or per row from its absolute maximum when x_scale is 0. The product
+// is accumulated in int32, and rescaling, bias and ReLU are applied to each
+// output tile as it leaves the kernel. bias is [N] or [1, N] and may be empty.
+Tensor linear(const Tensor& x, const Int8Weights& w, const Tensor& bias,
+              float x_scale = 0.0f, bool relu = false);
+// The same into out, which must be contiguous float32 [M, N]. Quantized
+// activations go to per-thread scratch, so with float32 contiguous x and bias
+// repeated calls allocate nothing.
+void linear(const Tensor& x, const Int8Weights& w, const Tensor& bias, Tensor& out,
+            float x_scale = 0.0f, bool relu = false);
+
+} // namespace quant
+} // namespace core
+} // namespace mtf
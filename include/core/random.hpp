@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mtf {
+namespace core {
+
+// Counter-based random number generator (Philox4x32-10). Each draw of four
+// 32-bit words is a pure function of the seed and a 64-bit block counter, so
+// any range of a fill can be computed on its own: parallel fills give the same
+// numbers for a seed whatever the thread count, and so does filling a tensor in
+// one call versus element by element in another layout. A fill of n values
+// consumes ceil(n / 4) counters, and the next fill starts after them.
+class Generator {
+public:
+    explicit Generator(uint64_t seed);
+
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    // Restarts the sequence from counter 0 under a new seed.
+    void manual_seed(uint64_t seed);
+    uint64_t seed() const { return seed_.load(std::memory_order_relaxed); }
+    uint64_t offset() const { return offset_.load(std::memory_order_relaxed); }
+
+    // Normal samples by Box-Muller, four per counter.
+    void normal(float* dst, size_t n, float mean = 0.0f, float std = 1.0f);
+    // Uniform samples in [low, high), four per counter; 24 random bits each.
+    void uniform(float* dst, size_t n, float low = 0.0f, float high = 1.0f);
+
+private:
+    uint64_t reserve(size_t n);
+
+    std::atomic<uint64_t> seed_;
+    std::atomic<uint64_t> offset_;
+};
+
+// Shared generator behind Tensor::randn and Tensor::rand. Seeded from
+// MTF_SEED when it is set, otherwise from std::random_device.
+Generator& default_generator();
+void manual_seed(uint64_t seed);
+
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "kernels.hpp"
+#include "tensor.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace mtf {
+namespace core {
+
+// Row-major R x C matrix whose shape is part of its type and whose elements
+// live inline, so it never touches the heap. Meant for tiny models, where
+// allocating tensors and looping over runtime shapes costs more than the
+// arithmetic. Converts to and from Tensor for loading and saving.
+template <typename T, size_t R, size_t C>
+struct StaticTensor {
+    static_assert(R > 0 && C > 0, "StaticTensor dimensions must be positive");
+
+    static constexpr size_t rows = R;
+    static constexpr size_t cols = C;
+    static constexpr size_t size = R * C;
+
+    alignas(32) T data[R * C];
+
+    T& operator()(size_t i, size_t j) { return data[i * C + j]; }
+    const T& operator()(size_t i, size_t j) const { return data[i * C + j]; }
+
+    static StaticTensor filled(T value) {
+        StaticTensor t;
+        for (size_t i = 0; i < size; ++i) t.data[i] = value;
+        return t;
+    }
+    static StaticTensor zeros() { return filled(T(0)); }
+
+    // t must have shape [R, C], or [C] when R == 1; any dtype and strides.
+    static StaticTensor from_tensor(const Tensor& t) {
+        static_assert(std::is_same<T, float>::value, "Tensor interop needs float elements");
+        const Tensor::Shape& shape = t.shape();
+        bool fits = (shape.size() == 2 && shape[0] == R && shape[1] == C) ||
+                    (R == 1 && shape.size() == 1 && shape[0] == C);
+        if (!fits) {
+            throw std::invalid_argument("StaticTensor: expected a " + std::to_string(R) + "x" +
+                                        std::to_string(C) + " tensor");
+        }
+        Tensor src = t.to(DType::Float32).contiguous();
+        StaticTensor result;
+        std::memcpy(result.data, src.data(), sizeof(result.data));
+        return result;
+    }
+
+    Tensor to_tensor() const {
+        static_assert(std::is_same<T, float>::value, "Tensor interop needs float elements");
+        Tensor t({R, C});
+        std::memcpy(t.data(), data, sizeof(data));
+        return t;
+    }
+};
+
+namespace static_detail {
+
+// c[M, N] = sum over k of a(i, k) * b(k, j), with a and b given as accessors.
+// The bounds are constants, so the compiler vectorizes the j loop over a row
+// of b and of c; unrolling everything instead is slower and compiles slowly.
+template <size_t M, size_t K, size_t N, typename T, typename A, typename B>
+inline void product(T* c, A a, B b) {
+    for (size_t i = 0; i < M * N; ++i) c[i] = T(0);
+    for (size_t i = 0; i < M; ++i) {
+        for (size_t k = 0; k < K; ++k) {
+            const T a_ik = a(i, k);
+            for (size_t j = 0; j < N; ++j) c[i * N + j] += a_ik * b(k, j);
+        }
+    }
+}
+
+} // namespace static_detail
+
+namespace ops {
+
+// a * b
+template <typename T, size_t M, size_t K, size_t N>
+StaticTensor<T, M, N> matmul(const StaticTensor<T, M, K>& a, const StaticTensor<T, K, N>& b) {
+    StaticTensor<T, M, N> c;
+    static_detail::product<M, K, N>(c.data,
+        [&](size_t i, size_t k) { return a.data[i * K + k]; },
+        [&](size_t k, size_t j) { return b.data[k * N + j]; });
+    return c;
+}
+
+// a^T * b, for a [K, M]
+template <typename T, size_t K, size_t M, size_t N>
+StaticTensor<T, M, N> matmul_tn(const StaticTensor<T, K, M>& a, const StaticTensor<T, K, N>& b) {
+    StaticTensor<T, M, N> c;
+    static_detail::product<M, K, N>(c.data,
+        [&](size_t i, size_t k) { return a.data[k * M + i]; },
+        [&](size_t k, size_t j) { return b.data[k * N + j]; });
+    return c;
+}
+
+// a * b^T, for b [N, K]
+template <typename T, size_t M, size_t K, size_t N>
+StaticTensor<T, M, N> matmul_nt(const StaticTensor<T, M, K>& a, const StaticTensor<T, N, K>& b) {
+    StaticTensor<T, M, N> c;
+    static_detail::product<M, K, N>(c.data,
+        [&](size_t i, size_t k) { return a.data[i * K + k]; },
+        [&](size_t k, size_t j) { return b.data[j * K + k]; });
+    return c;
+}
+
+// Activations run the vectorized kernels of the active instruction set over
+// the inline elements.
+template <size_t R, size_t C>
+StaticTensor<float, R, C> relu(const StaticTensor<float, R, C>& x) {
+    StaticTensor<float, R, C> y;
+    kernels::table().max_scalar(x.data, 1, 0.0f, y.data, R * C);
+    return y;
+}
+
+template <size_t R, size_t C>
+StaticTensor<float, R, C> sigmoid(const StaticTensor<float, R, C>& x) {
+    StaticTensor<float, R, C> y;
+    kernels::table().sigmoid(x.data, y.data, R * C);
+    return y;
+}
+
+template <size_t R, size_t C>
+StaticTensor<float, R, C> tanh(const StaticTensor<float, R, C>& x) {
+    StaticTensor<float, R, C> y;
+    kernels::table().tanh(x.data, y.data, R * C);
+    return y;
+}
+
+} // namespace ops
+
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace mtf {
+namespace core {
+
+// Raw aligned buffer behind one or more tensors. Views of a tensor hold the same
+// Storage through a shared_ptr, so the buffer lives as long as any of them.
+// Inside a StepArena scope the buffer comes from the thread's step arena.
+class Storage {
+public:
+    explicit Storage(size_t nbytes);
+    ~Storage();
+
+    Storage(const Storage&) = delete;
+    Storage& operator=(const Storage&) = delete;
+
+    void* data() const { return data_; }
+    size_t nbytes() const { return nbytes_; }
+    bool in_arena() const { return in_arena_; }
+
+    // Bumped each time a tensor hands out a mutable pointer into the buffer,
+    // so caches built from its contents can tell when they may be stale.
+    uint64_t version() const { return version_.load(std::memory_order_relaxed); }
+    void bump_version() { version_.fetch_add(1, std::memory_order_relaxed); }
+
+    // Allocates the Storage object itself from the step arena when one is active.
+    static std::shared_ptr<Storage> create(size_t nbytes);
+
+private:
+    void* data_;
+    size_t nbytes_;
+    bool in_arena_;
+    std::atomic<uint64_t> version_{0};
+};
+
+} // namespace core
+} // namespace mtf
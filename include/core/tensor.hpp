@@ -5,10 +5,20 @@
 #include <string>
 #include <initializer_list>
 #include <iostream>
+#include <cassert>
+
+#include "dtype.hpp"
+#include "storage.hpp"
 
 namespace mtf {
 namespace core {
 
+namespace expr {
+template <typename E> struct Expr;
+}
+
+class Generator;
+
 class Tensor {
 public:
     using Shape = std::vector<size_t>;
@@ -16,19 +26,27 @@ public:
 
     Tensor();
     Tensor(const Shape& shape);
+    Tensor(const Shape& shape, DType dtype);
     Tensor(const Shape& shape, const std::vector<float>& data);
     Tensor(std::initializer_list<float> data, const Shape& shape);
     
+    // Copies are O(1) and alias the same storage, like views; use clone() for an
+    // independent deep copy.
     Tensor(const Tensor& other);
     Tensor(Tensor&& other) noexcept;
     Tensor& operator=(const Tensor& other);
     Tensor& operator=(Tensor&& other) noexcept;
 
+    // Evaluates a lazy expression (core/expr.hpp) into a new tensor.
+    template <typename E> Tensor(const expr::Expr<E>& e);
+    template <typename E> Tensor& operator=(const expr::Expr<E>& e);
+
     ~Tensor();
 
     float& at(const std::vector<size_t>& indices);
     const float& at(const std::vector<size_t>& indices) const;
     
+    // Flat element index; only meaningful for contiguous tensors.
     float& operator[](size_t index);
     const float& operator[](size_t index) const;
 
@@ -38,11 +56,48 @@ public:
     const Shape& shape() const { return shape_; }
     const Strides& strides() const { return strides_; }
     size_t size() const { return size_; }
-    float* data() { return data_; }
-    const float* data() const { return data_; }
+    DType dtype() const { return dtype_; }
+    size_t element_size() const { return dtype_size(dtype_); }
+
+    // Element access and data() are for float32 tensors and throw
+    // std::logic_error on others; 16-bit ones are read through raw_data() or
+    // converted with to().
+    float* data() { require_float32(); mark_written(); return static_cast<float*>(data_); }
+    const float* data() const { require_float32(); return static_cast<const float*>(data_); }
+    void* raw_data() { mark_written(); return data_; }
+    const void* raw_data() const { return data_; }
+
+    // Changes whenever the non-const accessors above hand out a pointer or a
+    // reference into this tensor's storage, through this tensor or any view
+    // sharing it. Kernels take their pointers once per call, not per element.
+    uint64_t version() const { return storage_ ? storage_->version() : 0; }
+
+    bool is_contiguous() const;
+    bool is_view() const { return !owns_memory_; }
+
+    // Views share this tensor's storage and never copy. view() needs a contiguous
+    // tensor; reshape() falls back to a copy when the layout cannot be reinterpreted.
+    Tensor view(const Shape& shape) const;
+    Tensor reshape(const Shape& shape) const;
+    Tensor slice(size_t dim, size_t start, size_t end) const;
+    Tensor narrow(size_t dim, size_t start, size_t length) const;
+    Tensor permute(const std::vector<size_t>& dims) const;
+    Tensor transpose(size_t dim0 = 0, size_t dim1 = 1) const;
+    // Returns *this when it is already contiguous, otherwise a packed copy.
+    Tensor contiguous() const;
+    Tensor clone() const;
+    // Returns *this when it already has the dtype, otherwise a contiguous copy
+    // converted to it.
+    Tensor to(DType dtype) const;
 
     void fill(float value);
+    // Draw from core::default_generator() unless given a generator. Values are
+    // assigned in logical element order, whatever the strides.
     void randn(float mean = 0.0f, float std = 1.0f);
+    void randn(float mean, float std, Generator& gen);
+    // Uniform in [low, high).
+    void rand(float low = 0.0f, float high = 1.0f);
+    void rand(float low, float high, Generator& gen);
     void print() const;
     
     bool save(const std::string& filepath) const;
@@ -51,7 +106,20 @@ public:
     static Strides compute_strides(const Shape& shape);
 
 private:
-    float* data_;
+    Tensor(std::shared_ptr<Storage> storage, void* data, DType dtype,
+           const Shape& shape, const Strides& strides);
+
+    void mark_written() { if (storage_) storage_->bump_version(); }
+    void require_float32() const { if (dtype_ != DType::Float32) throw_not_float32(); }
+    [[noreturn]] void throw_not_float32() const;
+    void* element(size_t offset) const;
+    void copy_to(void* dst) const;
+    // Writes a contiguous float32 tensor of the same shape into this one.
+    void assign_values(const Tensor& values);
+
+    std::shared_ptr<Storage> storage_;
+    void* data_;
+    DType dtype_;
     size_t size_;
     Shape shape_;
     Strides strides_;
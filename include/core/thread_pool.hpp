@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mtf {
+namespace core {
+
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t)>;
+
+    // num_threads counts the calling thread, so a pool of N spawns N - 1 workers.
+    explicit ThreadPool(size_t num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t num_threads() const { return workers_.size() + 1; }
+
+    // Runs task(i) for every i in [0, num_tasks) and returns once all are done.
+    // The calling thread takes part in the work. If a task throws, the tasks
+    // not yet started are skipped and the first exception is rethrown here.
+    void run(size_t num_tasks, const Task& task);
+
+    static ThreadPool& global();
+
+private:
+    void worker_loop();
+    void execute_tasks(const Task* task, size_t num_tasks);
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::mutex run_mutex_;
+
+    const Task* task_;
+    size_t num_tasks_;
+    std::atomic<size_t> next_task_;
+    std::atomic<size_t> remaining_;
+    std::atomic<bool> failed_;
+    std::exception_ptr error_;
+    size_t active_;
+    uint64_t generation_;
+    bool stop_;
+};
+
+// Thread count of the shared pool. Defaults to MTF_NUM_THREADS when set, otherwise
+// to std::thread::hardware_concurrency(). Must not be called while ops are running.
+void set_num_threads(size_t num_threads);
+size_t get_num_threads();
+
+// Splits [begin, end) into contiguous chunks of at least `grain` iterations and
+// runs fn(chunk_begin, chunk_end) on the shared pool. Ranges no larger than one
+// grain, single-threaded pools and nested calls run inline on the caller.
+void parallel_for(size_t begin, size_t end, size_t grain,
+                  const std::function<void(size_t, size_t)>& fn);
+
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+namespace mtf {
+namespace core {
+namespace vmath {
+
+// y[i] = f(x[i]) for i < n; x and y may alias. On CPUs with AVX2 and FMA these
+// evaluate polynomial approximations after range reduction, eight lanes at a
+// time; elsewhere they fall back to the reference versions below. Maximum
+// error against the correctly rounded result, measured over every float:
+//   exp      1 ulp
+//   log      1 ulp   (denormal inputs included)
+//   tanh     1 ulp
+//   sigmoid  3 ulp
+// Results in the denormal range lose precision gradually. Infinities and NaNs
+// follow the C library.
+void exp(const float* x, float* y, size_t n);
+void log(const float* x, float* y, size_t n);
+void tanh(const float* x, float* y, size_t n);
+void sigmoid(const float* x, float* y, size_t n);
+
+// Precise scalar versions built on the C library, one element at a time.
+namespace reference {
+
+void exp(const float* x, float* y, size_t n);
+void log(const float* x, float* y, size_t n);
+void tanh(const float* x, float* y, size_t n);
+void sigmoid(const float* x, float* y, size_t n);
+
+} // namespace reference
+
+} // namespace vmath
+} // namespace core
+} // namespace mtf
@@ -1,16 +1,25 @@
 #pragma once
 
+#include "core/arena.hpp"
+#include "core/cpu.hpp"
+#include "core/expr.hpp"
 #include "core/memory.hpp"
 #include "core/tensor.hpp"
 #include "core/ops_cpu.hpp"
+#include "core/quant.hpp"
+#include "core/random.hpp"
+#include "core/static_tensor.hpp"
+#include "core/thread_pool.hpp"
 
 #include "autograd/node.hpp"
 #include "autograd/engine.hpp"
+#include "autograd/capture.hpp"
 
 #include "nn/layers.hpp"
 #include "nn/activations.hpp"
 #include "nn/loss.hpp"
 #include "nn/model_metadata.hpp"
+#include "nn/static_layers.hpp"
 
 #include "optim/optimizer.hpp"
 #include "optim/sgd.hpp"
@@ -18,6 +27,11 @@
 
 namespace mtf {
 
+using core::StepArena;
+using core::manual_seed;
+using autograd::NoGradGuard;
+using autograd::CapturedStep;
+
 inline autograd::NodePtr Variable(core::Tensor::Shape shape, bool requires_grad = false) {
     core::Tensor t(shape);
     t.randn(0.0f, 0.1f);
@@ -32,4 +46,8 @@ inline autograd::NodePtr matmul(const autograd::NodePtr& a, const autograd::Node
     return autograd::matmul(a, b);
 }
 
+inline autograd::NodePtr bmm(const autograd::NodePtr& a, const autograd::NodePtr& b) {
+    return autograd::bmm(a, b);
+}
+
 } // namespace mtf
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <string>
 #include "autograd/node.hpp"
+#include "core/gemm.hpp"
+#include "core/ops_cpu.hpp"
+#include "core/quant.hpp"
 
 namespace mtf {
 namespace nn {
@@ -29,16 +33,78 @@ public:
     std::vector<autograd::NodePtr> parameters() const override;
     
     bool save(const std::string& filepath) const;
+    // Returns a frozen layer.
     static Dense load(const std::string& filepath);
 
+    // Inference mode: the weight is packed once into the GEMM kernels' panel
+    // layout and forward() skips packing it. The packed path builds no graph,
+    // so it is taken under a NoGradGuard, or when neither the input nor the
+    // parameters require grad; otherwise forward() takes the regular path and
+    // the weight and bias still get their gradients. The packed copy is
+    // rebuilt on the next forward() after the weight's version() changes.
+    void freeze();
+    void unfreeze();
+    bool frozen() const { return frozen_; }
+
+    // Activation applied to the output inside forward(). Frozen layers fuse it
+    // with the bias into the matrix product; a single input row then goes
+    // through a matrix-vector kernel instead of the GEMM.
+    void set_activation(core::ops::Activation act) { activation_ = act; }
+    core::ops::Activation activation() const { return activation_; }
+
+    const autograd::NodePtr& weight() const { return weight_; }
+    const autograd::NodePtr& bias() const { return bias_; }
+    bool use_bias() const { return use_bias_; }
+
 private:
     autograd::NodePtr weight_;
     autograd::NodePtr bias_;
     bool use_bias_;
     size_t input_dim_;
     size_t output_dim_;
-    
+
+    core::ops::Activation activation_ = core::ops::Activation::None;
+    bool frozen_ = false;
+    core::PackedMatrix packed_weight_;
+    // Alias of the weight packed_weight_ was built from, and its version then.
+    core::Tensor packed_source_;
+    uint64_t packed_version_ = 0;
+
     void init_parameters(size_t input_dim, size_t output_dim);
+    bool packed_weight_current() const;
+    void pack_weight();
+};
+
+// Inference-only int8 copy of a trained Dense layer. Weights are quantized per
+// output channel. Inputs are quantized per row at run time until calibrate()
+// fixes a scale. With fuse_relu, or when the Dense has a Relu activation, the
+// layer computes relu(x * W + b) in one pass; a Sigmoid or Tanh activation is
+// applied to the output after the product. fuse_relu together with one of
+// those throws std::invalid_argument.
+class QuantizedDense : public Layer {
+public:
+    explicit QuantizedDense(const Dense& dense, bool fuse_relu = false);
+
+    autograd::NodePtr forward(autograd::NodePtr input) override;
+    std::vector<autograd::NodePtr> parameters() const override;
+
+    // Widens the calibrated input range to cover `input` and switches to the
+    // resulting fixed scale. Values outside the range saturate.
+    void calibrate(const core::Tensor& input);
+    float input_scale() const { return input_scale_; }
+
+    const core::quant::Int8Weights& weights() const { return *weights_; }
+
+private:
+    // Shared with the steps captured from this layer, which keep their own
+    // copies of the other settings: calibrate() after a capture does not change
+    // what the captured step computes.
+    std::shared_ptr<const core::quant::Int8Weights> weights_;
+    core::Tensor bias_;
+    bool fuse_relu_;
+    // Applied after the product; Relu is fused into it instead.
+    core::ops::Activation activation_ = core::ops::Activation::None;
+    float input_scale_ = 0.0f;
 };
 
 } // namespace nn
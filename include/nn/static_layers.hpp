@@ -0,0 +1,125 @@
+#pragma once
+
+#include "core/static_tensor.hpp"
+#include "nn/layers.hpp"
+#include <cmath>
+#include <string>
+
+namespace mtf {
+namespace nn {
+
+// Dense layer with its sizes fixed at compile time, on StaticTensor, for tiny
+// models. There is no graph: backward() is called explicitly with the input of
+// the matching forward() and accumulates into the gradient members. Weights
+// are stored and initialized like Dense, and load() and save() use the same
+// files.
+template <size_t In, size_t Out>
+class StaticDense {
+public:
+    using Weight = core::StaticTensor<float, In, Out>;
+    using Bias = core::StaticTensor<float, 1, Out>;
+    template <size_t B> using Input = core::StaticTensor<float, B, In>;
+    template <size_t B> using Output = core::StaticTensor<float, B, Out>;
+
+    Weight weight;
+    Bias bias;
+    Weight grad_weight = Weight::zeros();
+    Bias grad_bias = Bias::zeros();
+
+    StaticDense() {
+        core::Tensor w({In, Out});
+        w.randn(0.0f, std::sqrt(2.0f / (In + Out)));
+        weight = Weight::from_tensor(w);
+        bias = Bias::zeros();
+    }
+
+    explicit StaticDense(const Dense& dense)
+        : weight(Weight::from_tensor(dense.weight()->value)),
+          bias(dense.use_bias() ? Bias::from_tensor(dense.bias()->value) : Bias::zeros()) {}
+
+    Dense to_dense() const {
+        return Dense(In, Out, true, weight.to_tensor(), bias.to_tensor());
+    }
+
+    bool save(const std::string& filepath) const { return to_dense().save(filepath); }
+    // Throws std::invalid_argument when the saved layer has other sizes.
+    static StaticDense load(const std::string& filepath) { return StaticDense(Dense::load(filepath)); }
+
+    // y = x * weight + bias
+    template <size_t B>
+    Output<B> forward(const Input<B>& x) const {
+        Output<B> y = core::ops::matmul(x, weight);
+        for (size_t i = 0; i < B; ++i) {
+            for (size_t j = 0; j < Out; ++j) y(i, j) += bias.data[j];
+        }
+        return y;
+    }
+
+    // Accumulates the gradients for dL/dy = grad_y at input x and returns dL/dx.
+    template <size_t B>
+    Input<B> backward(const Input<B>& x, const Output<B>& grad_y) {
+        Weight dw = core::ops::matmul_tn(x, grad_y);
+        for (size_t i = 0; i < Weight::size; ++i) grad_weight.data[i] += dw.data[i];
+        for (size_t i = 0; i < B; ++i) {
+            for (size_t j = 0; j < Out; ++j) grad_bias.data[j] += grad_y(i, j);
+        }
+        return core::ops::matmul_nt(grad_y, weight);
+    }
+
+    void zero_grad() {
+        grad_weight = Weight::zeros();
+        grad_bias = Bias::zeros();
+    }
+
+    void sgd_step(float learning_rate) {
+        for (size_t i = 0; i < Weight::size; ++i) weight.data[i] -= learning_rate * grad_weight.data[i];
+        for (size_t j = 0; j < Out; ++j) bias.data[j] -= learning_rate * grad_bias.data[j];
+    }
+};
+
+namespace functional {
+
+// Gradients through the activations, from their outputs y and dL/dy.
+template <size_t R, size_t C>
+core::StaticTensor<float, R, C> relu_backward(const core::StaticTensor<float, R, C>& y,
+                                              const core::StaticTensor<float, R, C>& grad_y) {
+    core::StaticTensor<float, R, C> g;
+    for (size_t i = 0; i < R * C; ++i) g.data[i] = y.data[i] > 0.0f ? grad_y.data[i] : 0.0f;
+    return g;
+}
+
+template <size_t R, size_t C>
+core::StaticTensor<float, R, C> sigmoid_backward(const core::StaticTensor<float, R, C>& y,
+                                                 const core::StaticTensor<float, R, C>& grad_y) {
+    core::StaticTensor<float, R, C> g;
+    for (size_t i = 0; i < R * C; ++i) g.data[i] = grad_y.data[i] * y.data[i] * (1.0f - y.data[i]);
+    return g;
+}
+
+template <size_t R, size_t C>
+core::StaticTensor<float, R, C> tanh_backward(const core::StaticTensor<float, R, C>& y,
+                                              const core::StaticTensor<float, R, C>& grad_y) {
+    core::StaticTensor<float, R, C> g;
+    for (size_t i = 0; i < R * C; ++i) g.data[i] = grad_y.data[i] * (1.0f - y.data[i] * y.data[i]);
+    return g;
+}
+
+// Mean squared error as MSELoss computes it; writes dL/dprediction to grad.
+template <size_t R, size_t C>
+float mse_loss(const core::StaticTensor<float, R, C>& prediction,
+               const core::StaticTensor<float, R, C>& target,
+               core::StaticTensor<float, R, C>& grad) {
+    constexpr float scale = 1.0f / static_cast<float>(R * C);
+    float sum = 0.0f;
+    for (size_t i = 0; i < R * C; ++i) {
+        float d = prediction.data[i] - target.data[i];
+        sum += d * d;
+        grad.data[i] = 2.0f * scale * d;
+    }
+    return sum * scale;
+}
+
+} // namespace functional
+
+} // namespace nn
+} // namespace mtf
@@ -0,0 +1,119 @@
+#include "autograd/capture.hpp"
+#include "autograd/engine.hpp"
+#include "optim/optimizer.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace mtf {
+namespace autograd {
+
+namespace {
+
+thread_local CapturedStep* current_capture = nullptr;
+
+struct RecordingScope {
+    CapturedStep* outer = current_capture;
+    explicit RecordingScope(CapturedStep* step) { current_capture = step; }
+    ~RecordingScope() { current_capture = outer; }
+};
+
+} // namespace
+
+CapturedStep::CapturedStep(Forward forward, optim::Optimizer& optimizer)
+    : forward_(std::move(forward)), optimizer_(optimizer) {}
+
+CapturedStep* CapturedStep::recording() {
+    return current_capture;
+}
+
+void CapturedStep::record(NodePtr result, std::vector<NodePtr> inputs, std::function<void()> recompute) {
+    results_.push_back(std::move(result));
+    for (auto& input : inputs) {
+        inputs_.push_back(std::move(input));
+    }
+    recompute_.push_back(std::move(recompute));
+}
+
+const NodePtr& CapturedStep::step() {
+    if (!loss_ || shapes_changed()) {
+        capture();
+    } else {
+        for (Leaf& leaf : leaves_) {
+            if (!leaf.node->value.is_contiguous()) {
+                leaf.node->value = leaf.node->value.contiguous();
+            }
+        }
+        for (auto& recompute : recompute_) {
+            recompute();
+        }
+    }
+
+    optimizer_.zero_grad();
+    for (Leaf& leaf : leaves_) {
+        if (leaf.node->requires_grad) {
+            leaf.node->grad.fill(0.0f);
+        }
+    }
+    for (Node* node : backward_order_) {
+        node->grad.fill(0.0f);
+    }
+    loss_->grad.fill(1.0f);
+    for (Node* node : backward_order_) {
+        node->backward_fn();
+    }
+    optimizer_.step();
+    return loss_;
+}
+
+// Runs forward() with recording on and works out the leaves and the backward
+// order of what it built.
+void CapturedStep::capture() {
+    loss_.reset();
+    results_.clear();
+    inputs_.clear();
+    recompute_.clear();
+    leaves_.clear();
+    backward_order_.clear();
+
+    {
+        RecordingScope scope(this);
+        loss_ = forward_();
+    }
+    if (!loss_) {
+        throw std::invalid_argument("CapturedStep: forward returned no loss");
+    }
+    ++captures_;
+
+    std::unordered_set<const Node*> recorded;
+    for (const auto& result : results_) {
+        recorded.insert(result.get());
+    }
+    std::unordered_set<const Node*> seen;
+    for (const auto& input : inputs_) {
+        if (!recorded.count(input.get()) && seen.insert(input.get()).second) {
+            leaves_.push_back({input.get(), input->value.shape()});
+        }
+    }
+
+    for (const auto& node : Engine::topological_sort(loss_)) {
+        if (!node->backward_fn || !node->requires_grad) continue;
+        // Replaying would leave its value as it was at capture.
+        if (!recorded.count(node.get())) {
+            loss_.reset();
+            throw std::logic_error("CapturedStep: op " + node->op_name + " cannot be captured");
+        }
+        backward_order_.push_back(node.get());
+    }
+    std::reverse(backward_order_.begin(), backward_order_.end());
+}
+
+bool CapturedStep::shapes_changed() const {
+    for (const Leaf& leaf : leaves_) {
+        if (leaf.node->value.shape() != leaf.shape) return true;
+    }
+    return false;
+}
+
+} // namespace autograd
+} // namespace mtf
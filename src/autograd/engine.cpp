@@ -1,40 +1,397 @@
 #include "autograd/engine.hpp"
-#include <stack>
+#include "core/thread_pool.hpp"
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
-#include <algorithm>
 
 namespace mtf {
 namespace autograd {
 
+namespace {
+
+constexpr uint32_t NO_NODE = UINT32_MAX;
+constexpr uint8_t HAS_BACKWARD = 1;
+constexpr uint8_t REQUIRES_GRAD = 2;
+
+struct Frame {
+    Node* node;
+    size_t next_parent;
+};
+
+// The visit marks on the nodes belong to one traversal at a time. A thread
+// that finds them taken keeps its own visited set instead, so threads may
+// sort graphs that share nodes.
+std::atomic<bool> marks_taken{false};
+uint64_t last_epoch = 0;
+
+struct Marks {
+    bool owned = !marks_taken.exchange(true, std::memory_order_acquire);
+    ~Marks() {
+        if (owned) marks_taken.store(false, std::memory_order_release);
+    }
+    // An epoch no node is marked with yet.
+    uint64_t next_epoch() { return ++last_epoch; }
+};
+
+// Depth-first post-order with an explicit stack, visiting parents in order.
+// first_visit(node) is true the first time it is asked about node.
+template <typename FirstVisit>
+void sort_graph(Node* root, std::vector<Node*>& order, FirstVisit first_visit) {
+    thread_local std::vector<Frame> stack;
+    stack.clear();
+
+    first_visit(root);
+    stack.push_back({root, 0});
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.next_parent < frame.node->parents.size()) {
+            Node* parent = frame.node->parents[frame.next_parent++].get();
+            if (parent && first_visit(parent)) {
+                stack.push_back({parent, 0});
+            }
+        } else {
+            order.push_back(frame.node);
+            stack.pop_back();
+        }
+    }
+}
+
+void sort_marked(Node* root, std::vector<Node*>& order, uint64_t epoch) {
+    sort_graph(root, order, [epoch](Node* node) {
+        if (node->visit_epoch == epoch) return false;
+        node->visit_epoch = epoch;
+        return true;
+    });
+}
+
+void sort_hashed(Node* root, std::vector<Node*>& order) {
+    thread_local std::unordered_set<const Node*> visited;
+    visited.clear();
+    sort_graph(root, order, [](Node* node) { return visited.insert(node).second; });
+}
+
+void sort_into(Node* root, std::vector<Node*>& order) {
+    Marks marks;
+    if (marks.owned) {
+        sort_marked(root, order, marks.next_epoch());
+    } else {
+        sort_hashed(root, order);
+    }
+}
+
+// The backward functions of a graph as tasks, in backward()'s order, with the
+// tasks each one releases and how many tasks each waits for. A task is the
+// position of its node in the order.
+struct ParallelSchedule {
+    std::vector<uint32_t> tasks;
+    std::vector<uint32_t> dependencies;
+    // Successors of task i are successors[successor_begin[i], successor_begin[i + 1]).
+    std::vector<uint32_t> successor_begin;
+    std::vector<uint32_t> successors;
+};
+
+// A graph's backward order and, once backward_parallel() has run on it, its
+// tasks, with the shape they were built for: for each node in the order, the
+// positions of its parents and whether it has a backward function and
+// requires grad. A graph rebuilt with the same shape, as a training loop
+// does every step, reuses both after one pass that checks it.
+struct Schedule {
+    std::vector<Node*> order;
+    // Parents of order[i] are parents[parent_begin[i], parent_begin[i + 1]).
+    std::vector<uint32_t> parent_begin;
+    std::vector<uint32_t> parents;
+    std::vector<uint8_t> flags;
+    bool has_parallel = false;
+    ParallelSchedule parallel;
+};
+
+thread_local Schedule cached_schedule;
+thread_local bool in_backward = false;
+
+struct BackwardScope {
+    bool outer = !in_backward;
+    BackwardScope() { in_backward = true; }
+    ~BackwardScope() {
+        if (outer) in_backward = false;
+    }
+};
+
+uint8_t flags_of(const Node* node) {
+    return static_cast<uint8_t>((node->backward_fn ? HAS_BACKWARD : 0) | (node->requires_grad ? REQUIRES_GRAD : 0));
+}
+
+// Records the shape of the graph in schedule.order. position(node) is the
+// node's index in the order.
+template <typename Position>
+void record_shape(Schedule& schedule, Position position) {
+    schedule.parent_begin.assign(1, 0);
+    schedule.parents.clear();
+    schedule.flags.clear();
+    for (Node* node : schedule.order) {
+        for (const auto& parent : node->parents) {
+            schedule.parents.push_back(parent ? position(parent.get()) : NO_NODE);
+        }
+        schedule.parent_begin.push_back(static_cast<uint32_t>(schedule.parents.size()));
+        schedule.flags.push_back(flags_of(node));
+    }
+    schedule.has_parallel = false;
+}
+
+// Whether root's graph has the shape recorded in schedule, filling in its
+// order on the way. The walk goes from the root down, so every node is known
+// from a child before its own parents are checked; marking the nodes with a
+// fresh epoch catches one node turning up at two positions.
+bool matches_shape(Node* root, Schedule& schedule, uint64_t epoch) {
+    const size_t n = schedule.flags.size();
+    if (n == 0) return false;
+
+    std::vector<Node*>& order = schedule.order;
+    order.assign(n, nullptr);
+    order[n - 1] = root;
+    root->visit_epoch = epoch;
+    for (size_t i = n; i-- > 0;) {
+        Node* node = order[i];
+        const uint32_t begin = schedule.parent_begin[i];
+        const uint32_t end = schedule.parent_begin[i + 1];
+        if (node->parents.size() != end - begin || flags_of(node) != schedule.flags[i]) return false;
+
+        for (uint32_t j = begin; j < end; ++j) {
+            Node* parent = node->parents[j - begin].get();
+            const uint32_t position = schedule.parents[j];
+            if (!parent || position == NO_NODE) {
+                if (parent || position != NO_NODE) return false;
+            } else if (!order[position]) {
+                if (parent->visit_epoch == epoch) return false;
+                parent->visit_epoch = epoch;
+                order[position] = parent;
+            } else if (order[position] != parent) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Fills schedule.order for root's graph, sorting it only when its shape is
+// not the one schedule was built for.
+void prepare(Node* root, Schedule& schedule) {
+    Marks marks;
+    if (!marks.owned) {
+        schedule.order.clear();
+        sort_hashed(root, schedule.order);
+        std::unordered_map<const Node*, uint32_t> position_of;
+        for (size_t i = 0; i < schedule.order.size(); ++i) {
+            position_of.emplace(schedule.order[i], static_cast<uint32_t>(i));
+        }
+        record_shape(schedule, [&](const Node* node) { return position_of[node]; });
+        return;
+    }
+
+    if (matches_shape(root, schedule, marks.next_epoch())) return;
+
+    schedule.order.clear();
+    sort_marked(root, schedule.order, marks.next_epoch());
+    for (size_t i = 0; i < schedule.order.size(); ++i) {
+        schedule.order[i]->visit_index = static_cast<uint32_t>(i);
+    }
+    record_shape(schedule, [](const Node* node) { return node->visit_index; });
+}
+
+// A backward function adds into the gradients of its parents that require
+// grad. Each such gradient gets its writers in backward()'s order, chained so
+// that each waits for the one before, and its own node's function waits for
+// the last of them.
+void build_dependencies(Schedule& schedule) {
+    ParallelSchedule& parallel = schedule.parallel;
+    const size_t nodes = schedule.order.size();
+
+    parallel.tasks.clear();
+    std::vector<uint32_t> task_of(nodes, NO_NODE);
+    for (size_t i = nodes; i-- > 0;) {
+        if (schedule.flags[i] & HAS_BACKWARD) {
+            task_of[i] = static_cast<uint32_t>(parallel.tasks.size());
+            parallel.tasks.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    const uint32_t n = static_cast<uint32_t>(parallel.tasks.size());
+
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    std::vector<uint32_t> last_writer(nodes, NO_NODE);
+    for (uint32_t i = 0; i < n; ++i) {
+        const uint32_t node = parallel.tasks[i];
+        for (uint32_t j = schedule.parent_begin[node]; j < schedule.parent_begin[node + 1]; ++j) {
+            const uint32_t parent = schedule.parents[j];
+            if (parent == NO_NODE || !(schedule.flags[parent] & REQUIRES_GRAD)) continue;
+            uint32_t& writer = last_writer[parent];
+            if (writer == i) continue;
+            if (writer != NO_NODE) {
+                edges.emplace_back(writer, i);
+            }
+            writer = i;
+        }
+    }
+    for (size_t node = 0; node < nodes; ++node) {
+        if (last_writer[node] != NO_NODE && task_of[node] != NO_NODE) {
+            edges.emplace_back(last_writer[node], task_of[node]);
+        }
+    }
+
+    parallel.dependencies.assign(n, 0);
+    parallel.successor_begin.assign(n + 1, 0);
+    for (const auto& edge : edges) {
+        ++parallel.successor_begin[edge.first + 1];
+        ++parallel.dependencies[edge.second];
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        parallel.successor_begin[i + 1] += parallel.successor_begin[i];
+    }
+    parallel.successors.resize(edges.size());
+    std::vector<uint32_t> fill(parallel.successor_begin.begin(), parallel.successor_begin.end() - 1);
+    for (const auto& edge : edges) {
+        parallel.successors[fill[edge.first]++] = edge.second;
+    }
+    schedule.has_parallel = true;
+}
+
+// Ready tasks of one pool thread. The owner takes the newest, which it just
+// released and whose inputs are still in its cache; idle threads steal the
+// oldest.
+struct alignas(64) TaskQueue {
+    std::mutex mutex;
+    std::deque<uint32_t> tasks;
+
+    void push(uint32_t task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(task);
+    }
+    bool pop(uint32_t& task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) return false;
+        task = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+    bool steal(uint32_t& task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) return false;
+        task = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+};
+
+void run_parallel(const Schedule& graph, core::ThreadPool& pool) {
+    const ParallelSchedule& schedule = graph.parallel;
+    const size_t n = schedule.tasks.size();
+    const size_t threads = pool.num_threads();
+
+    std::vector<std::atomic<uint32_t>> pending(n);
+    std::vector<TaskQueue> queues(threads);
+    size_t next_queue = 0;
+    for (size_t i = 0; i < n; ++i) {
+        pending[i].store(schedule.dependencies[i], std::memory_order_relaxed);
+        if (schedule.dependencies[i] == 0) {
+            queues[next_queue++ % threads].tasks.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    std::atomic<size_t> finished{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    pool.run(threads, [&](size_t self) {
+        while (finished.load(std::memory_order_acquire) < n && !failed.load(std::memory_order_relaxed)) {
+            uint32_t task;
+            bool found = queues[self].pop(task);
+            for (size_t k = 1; !found && k < threads; ++k) {
+                found = queues[(self + k) % threads].steal(task);
+            }
+            if (!found) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            try {
+                graph.order[schedule.tasks[task]]->backward_fn();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+                failed.store(true, std::memory_order_relaxed);
+            }
+            for (uint32_t s = schedule.successor_begin[task]; s < schedule.successor_begin[task + 1]; ++s) {
+                uint32_t next = schedule.successors[s];
+                if (pending[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    queues[self].push(next);
+                }
+            }
+            finished.fetch_add(1, std::memory_order_acq_rel);
+        }
+    });
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace
+
 void Engine::backward(NodePtr root) {
     if (!root) return;
 
-    std::vector<NodePtr> sorted = topological_sort(root);
+    // A backward function that calls backward gets a schedule of its own
+    // instead of replacing the one being walked.
+    Schedule nested;
+    Schedule& schedule = in_backward ? nested : cached_schedule;
+    prepare(root.get(), schedule);
+
     root->grad.fill(1.0f);
 
-    for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) {
-        NodePtr node = *it;
+    BackwardScope scope;
+    for (auto it = schedule.order.rbegin(); it != schedule.order.rend(); ++it) {
+        Node* node = *it;
         if (node->backward_fn) {
             node->backward_fn();
         }
     }
 }
 
+void Engine::backward_parallel(NodePtr root) {
+    if (!root) return;
+
+    core::ThreadPool& pool = core::ThreadPool::global();
+    if (pool.num_threads() == 1) {
+        backward(root);
+        return;
+    }
+
+    Schedule nested;
+    Schedule& schedule = in_backward ? nested : cached_schedule;
+    prepare(root.get(), schedule);
+    if (!schedule.has_parallel) {
+        build_dependencies(schedule);
+    }
+
+    root->grad.fill(1.0f);
+
+    BackwardScope scope;
+    run_parallel(schedule, pool);
+}
+
 std::vector<NodePtr> Engine::topological_sort(NodePtr root) {
     std::vector<NodePtr> sorted;
-    std::unordered_set<NodePtr> visited;
-    
-    std::function<void(NodePtr)> visit = [&](NodePtr node) {
-        if (!node || visited.count(node)) return;
-        visited.insert(node);
-        
-        for (auto& parent : node->parents) {
-            visit(parent);
-        }
-        sorted.push_back(node);
-    };
-
-    visit(root);
+    if (!root) return sorted;
+
+    std::vector<Node*> order;
+    sort_into(root.get(), order);
+    sorted.reserve(order.size());
+    for (Node* node : order) {
+        sorted.push_back(node->shared_from_this());
+    }
     return sorted;
 }
 
@@ -1,20 +1,66 @@
 #include "autograd/node.hpp"
+#include "autograd/capture.hpp"
+#include "core/arena.hpp"
 #include "core/ops_cpu.hpp"
+#include <algorithm>
 #include <iostream>
 
 namespace mtf {
 namespace autograd {
 
+namespace {
+
+thread_local bool grad_mode = true;
+
+} // namespace
+
 Node::Node(core::Tensor val, bool req_grad, std::string op)
-    : value(val), op_name(op), requires_grad(req_grad) {
+    : value(val.is_contiguous() ? std::move(val) : val.contiguous()),
+      op_name(std::move(op)), requires_grad(req_grad) {
     if (requires_grad) {
-        grad = core::Tensor(val.shape());
+        grad = core::Tensor(value.shape());
         grad.fill(0.0f);
     }
 }
 
+// Releases the graph above this node one node at a time. Letting each node drop
+// its parents would recurse once per node and overflow the stack on long
+// chains. A node this loop holds the last reference to hands its parents, and
+// the references its backward function captured, over to the loop first.
+Node::~Node() {
+    std::vector<NodePtr> pending = std::move(parents);
+    backward_fn = nullptr;
+    while (!pending.empty()) {
+        NodePtr node = std::move(pending.back());
+        pending.pop_back();
+        if (node && node.use_count() == 1) {
+            for (auto& parent : node->parents) {
+                pending.push_back(std::move(parent));
+            }
+            node->parents.clear();
+            node->backward_fn = nullptr;
+        }
+    }
+}
+
 NodePtr Node::create(core::Tensor val, bool req_grad, std::string op) {
-    return std::make_shared<Node>(val, req_grad, op);
+    if (core::StepArena::active()) {
+        return std::allocate_shared<Node>(core::ArenaAllocator<Node>(),
+                                          std::move(val), req_grad, std::move(op));
+    }
+    return std::make_shared<Node>(std::move(val), req_grad, std::move(op));
+}
+
+bool grad_enabled() {
+    return grad_mode;
+}
+
+NoGradGuard::NoGradGuard() : previous_(grad_mode) {
+    grad_mode = false;
+}
+
+NoGradGuard::~NoGradGuard() {
+    grad_mode = previous_;
 }
 
 void Node::zero_grad() {
@@ -23,93 +69,216 @@ void Node::zero_grad() {
     }
 }
 
+namespace {
+
+// Temporaries for the gradient of a broadcast operand. Each backward function
+// keeps its own, sized on first use, so replays of a captured step reuse them.
+struct BroadcastScratch {
+    core::Tensor product;
+    core::Tensor reduced;
+};
+
+core::Tensor& sized(core::Tensor& scratch, const core::Tensor::Shape& shape) {
+    if (scratch.size() == 0 || scratch.shape() != shape) {
+        scratch = core::Tensor(shape);
+    }
+    return scratch;
+}
+
+// Adds alpha times the gradient of a (possibly broadcast) result into
+// node->grad. Adds into the existing grad buffer rather than rebinding it, so
+// parameter grads never end up pointing into a step arena. Only a broadcast
+// operand needs a temporary, for the reduced gradient.
+void accumulate_grad(const NodePtr& node, const core::Tensor& grad, BroadcastScratch& scratch,
+                     float alpha = 1.0f) {
+    if (grad.shape() == node->value.shape()) {
+        core::ops::axpy(alpha, grad, node->grad);
+    } else {
+        core::Tensor& reduced = sized(scratch.reduced, node->value.shape());
+        core::ops::reduce_to_shape(grad, node->value.shape(), reduced);
+        core::ops::axpy(alpha, reduced, node->grad);
+    }
+}
+
+// node->grad += grad * other, for the operands of an elementwise product.
+void accumulate_product(const NodePtr& node, const core::Tensor& grad, const core::Tensor& other,
+                        BroadcastScratch& scratch) {
+    if (grad.shape() == node->value.shape()) {
+        core::ops::addcmul_(node->grad, grad, other);
+    } else {
+        core::Tensor& product = sized(scratch.product, grad.shape());
+        core::ops::mul(grad, other, product);
+        accumulate_grad(node, product, scratch);
+    }
+}
+
+// out[M, N] = input * weight + bias, with bias a [1, N] row or null.
+void linear_into(const core::Tensor& input, const core::Tensor& weight, const core::Tensor* bias,
+                 core::Tensor& out) {
+    size_t M = out.shape()[0];
+    size_t N = out.shape()[1];
+    float beta = 0.0f;
+    if (bias) {
+        // 16-bit biases are widened; a float32 one is shared, not copied.
+        const core::Tensor b = bias->to(core::DType::Float32);
+        const float* b_ptr = b.data();
+        float* out_ptr = out.data();
+        for (size_t i = 0; i < M; ++i) {
+            std::copy(b_ptr, b_ptr + N, out_ptr + i * N);
+        }
+        beta = 1.0f;
+    }
+    core::ops::gemm(false, false, 1.0f, input, weight, beta, out);
+}
+
+} // namespace
+
 NodePtr operator+(const NodePtr& a, const NodePtr& b) {
-    auto result = Node::create(core::ops::add(a->value, b->value), 
-                               a->requires_grad || b->requires_grad, 
-                               "Add");
+    bool req_grad = grad_enabled() && (a->requires_grad || b->requires_grad);
+    auto result = Node::create(core::ops::add(a->value, b->value), req_grad, "Add");
+    if (auto* capture = CapturedStep::recording()) {
+        capture->record(result, {a, b}, [self = result.get(), a = a.get(), b = b.get()]() {
+            core::ops::add(a->value, b->value, self->value);
+        });
+    }
+    if (!req_grad) return result;
     result->parents = {a, b};
 
-    result->backward_fn = [result, a, b]() {
+    result->backward_fn = [self = result.get(), a, b,
+                           scratch_a = BroadcastScratch(), scratch_b = BroadcastScratch()]() mutable {
         if (a->requires_grad) {
-            a->grad = core::ops::add(a->grad, result->grad);
+            accumulate_grad(a, self->grad, scratch_a);
         }
         if (b->requires_grad) {
-            if (b->value.shape().size() == 2 && result->grad.shape().size() == 2 &&
-                b->value.shape()[0] == 1 && result->grad.shape()[0] > 1 &&
-                b->value.shape()[1] == result->grad.shape()[1]) {
-                size_t M = result->grad.shape()[0];
-                size_t N = result->grad.shape()[1];
-                const float* grad_ptr = result->grad.data();
-                float* b_grad_ptr = b->grad.data();
-                
-                for (size_t j = 0; j < N; ++j) {
-                    float sum = 0.0f;
-                    for (size_t i = 0; i < M; ++i) {
-                        sum += grad_ptr[i * N + j];
-                    }
-                    b_grad_ptr[j] += sum;
-                }
-            } else {
-                b->grad = core::ops::add(b->grad, result->grad);
-            }
+            accumulate_grad(b, self->grad, scratch_b);
         }
     };
     return result;
 }
 
 NodePtr operator-(const NodePtr& a, const NodePtr& b) {
-    auto result = Node::create(core::ops::sub(a->value, b->value), 
-                               a->requires_grad || b->requires_grad, 
-                               "Sub");
+    bool req_grad = grad_enabled() && (a->requires_grad || b->requires_grad);
+    auto result = Node::create(core::ops::sub(a->value, b->value), req_grad, "Sub");
+    if (auto* capture = CapturedStep::recording()) {
+        capture->record(result, {a, b}, [self = result.get(), a = a.get(), b = b.get()]() {
+            core::ops::sub(a->value, b->value, self->value);
+        });
+    }
+    if (!req_grad) return result;
     result->parents = {a, b};
 
-    result->backward_fn = [result, a, b]() {
+    result->backward_fn = [self = result.get(), a, b,
+                           scratch_a = BroadcastScratch(), scratch_b = BroadcastScratch()]() mutable {
         if (a->requires_grad) {
-            a->grad = core::ops::add(a->grad, result->grad);
+            accumulate_grad(a, self->grad, scratch_a);
         }
         if (b->requires_grad) {
-            auto neg_grad = core::ops::mul_scalar(result->grad, -1.0f);
-            b->grad = core::ops::add(b->grad, neg_grad);
+            accumulate_grad(b, self->grad, scratch_b, -1.0f);
         }
     };
     return result;
 }
 
 NodePtr operator*(const NodePtr& a, const NodePtr& b) {
-    auto result = Node::create(core::ops::mul(a->value, b->value), 
-                               a->requires_grad || b->requires_grad, 
-                               "Mul");
+    bool req_grad = grad_enabled() && (a->requires_grad || b->requires_grad);
+    auto result = Node::create(core::ops::mul(a->value, b->value), req_grad, "Mul");
+    if (auto* capture = CapturedStep::recording()) {
+        capture->record(result, {a, b}, [self = result.get(), a = a.get(), b = b.get()]() {
+            core::ops::mul(a->value, b->value, self->value);
+        });
+    }
+    if (!req_grad) return result;
     result->parents = {a, b};
 
-    result->backward_fn = [result, a, b]() {
+    result->backward_fn = [self = result.get(), a, b,
+                           scratch_a = BroadcastScratch(), scratch_b = BroadcastScratch()]() mutable {
         if (a->requires_grad) {
-            auto da = core::ops::mul(result->grad, b->value);
-            a->grad = core::ops::add(a->grad, da);
+            accumulate_product(a, self->grad, b->value, scratch_a);
         }
         if (b->requires_grad) {
-            auto db = core::ops::mul(result->grad, a->value);
-            b->grad = core::ops::add(b->grad, db);
+            accumulate_product(b, self->grad, a->value, scratch_b);
         }
     };
     return result;
 }
 
 NodePtr matmul(const NodePtr& a, const NodePtr& b) {
-    auto result = Node::create(core::ops::matmul(a->value, b->value), 
-                               a->requires_grad || b->requires_grad, 
-                               "MatMul");
+    bool req_grad = grad_enabled() && (a->requires_grad || b->requires_grad);
+    auto result = Node::create(core::ops::matmul(a->value, b->value), req_grad, "MatMul");
+    if (auto* capture = CapturedStep::recording()) {
+        capture->record(result, {a, b}, [self = result.get(), a = a.get(), b = b.get()]() {
+            core::ops::gemm(false, false, 1.0f, a->value, b->value, 0.0f, self->value);
+        });
+    }
+    if (!req_grad) return result;
     result->parents = {a, b};
 
-    result->backward_fn = [result, a, b]() {
+    result->backward_fn = [self = result.get(), a, b]() {
         if (a->requires_grad) {
-            auto b_t = core::ops::transpose(b->value);
-            auto da = core::ops::matmul(result->grad, b_t);
-            a->grad = core::ops::add(a->grad, da);
+            core::ops::gemm(false, true, 1.0f, self->grad, b->value, 1.0f, a->grad);
         }
         if (b->requires_grad) {
-            auto a_t = core::ops::transpose(a->value);
-            auto db = core::ops::matmul(a_t, result->grad);
-            b->grad = core::ops::add(b->grad, db);
+            core::ops::gemm(true, false, 1.0f, a->value, self->grad, 1.0f, b->grad);
+        }
+    };
+    return result;
+}
+
+NodePtr bmm(const NodePtr& a, const NodePtr& b) {
+    bool req_grad = grad_enabled() && (a->requires_grad || b->requires_grad);
+    auto result = Node::create(core::ops::bmm(a->value, b->value), req_grad, "BatchMatMul");
+    if (auto* capture = CapturedStep::recording()) {
+        capture->record(result, {a, b}, [self = result.get(), a = a.get(), b = b.get()]() {
+            core::ops::gemm_batched(false, false, 1.0f, a->value, b->value, 0.0f, self->value);
+        });
+    }
+    if (!req_grad) return result;
+    result->parents = {a, b};
+
+    result->backward_fn = [self = result.get(), a, b]() {
+        if (a->requires_grad) {
+            core::ops::gemm_batched(false, true, 1.0f, self->grad, b->value, 1.0f, a->grad);
+        }
+        if (b->requires_grad) {
+            core::ops::gemm_batched(true, false, 1.0f, a->value, self->grad, 1.0f, b->grad);
+        }
+    };
+    return result;
+}
+
+NodePtr linear(const NodePtr& input, const NodePtr& weight, const NodePtr& bias) {
+    core::Tensor out({input->value.shape()[0], weight->value.shape()[1]});
+    linear_into(input->value, weight->value, bias ? &bias->value : nullptr, out);
+
+    bool req_grad = grad_enabled() && (input->requires_grad || weight->requires_grad ||
+                                       (bias && bias->requires_grad));
+    auto result = Node::create(std::move(out), req_grad, "Linear");
+    if (auto* capture = CapturedStep::recording()) {
+        std::vector<NodePtr> inputs = {input, weight};
+        if (bias) {
+            inputs.push_back(bias);
+        }
+        capture->record(result, std::move(inputs),
+                        [self = result.get(), input = input.get(), weight = weight.get(), bias = bias.get()]() {
+            linear_into(input->value, weight->value, bias ? &bias->value : nullptr, self->value);
+        });
+    }
+    if (!req_grad) return result;
+    result->parents = {input, weight};
+    if (bias) {
+        result->parents.push_back(bias);
+    }
+
+    result->backward_fn = [self = result.get(), input, weight, bias,
+                           scratch = BroadcastScratch()]() mutable {
+        if (input->requires_grad) {
+            core::ops::gemm(false, true, 1.0f, self->grad, weight->value, 1.0f, input->grad);
+        }
+        if (weight->requires_grad) {
+            core::ops::gemm(true, false, 1.0f, input->value, self->grad, 1.0f, weight->grad);
+        }
+        if (bias && bias->requires_grad) {
+            accumulate_grad(bias, self->grad, scratch);
         }
     };
     return result;
@@ -0,0 +1,144 @@
+#include "core/arena.hpp"
+#include "core/memory.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace mtf {
+namespace core {
+
+namespace {
+
+constexpr size_t ALIGNMENT = 64;
+constexpr size_t DEFAULT_CHUNK_BYTES = size_t(1) << 20;
+
+// A chunk counts one reference for the arena that bumps into it plus one per
+// live allocation; whoever drops the count to zero frees it.
+struct Chunk {
+    std::atomic<size_t> refs;
+    size_t capacity;
+    size_t used;
+
+    char* data() { return reinterpret_cast<char*>(this) + ALIGNMENT; }
+};
+static_assert(sizeof(Chunk) <= ALIGNMENT, "chunk header must fit in one cache line");
+
+struct AllocationHeader {
+    Chunk* chunk;
+};
+
+Chunk* new_chunk(size_t capacity) {
+    void* mem = aligned_alloc(ALIGNMENT + capacity, ALIGNMENT);
+    Chunk* chunk = new (mem) Chunk();
+    chunk->refs.store(1);
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    return chunk;
+}
+
+void release_chunk(Chunk* chunk) {
+    if (chunk->refs.fetch_sub(1) == 1) {
+        chunk->~Chunk();
+        aligned_free(chunk);
+    }
+}
+
+class Arena {
+public:
+    ~Arena() {
+        for (Chunk* chunk : chunks_) {
+            release_chunk(chunk);
+        }
+    }
+
+    void* allocate(size_t bytes) {
+        size_t need = ALIGNMENT + (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+        Chunk* chunk = chunks_.empty() ? nullptr : chunks_.back();
+        if (!chunk || chunk->used + need > chunk->capacity) {
+            size_t last = chunk ? chunk->capacity : DEFAULT_CHUNK_BYTES / 2;
+            chunk = new_chunk(std::max(need, last * 2));
+            chunks_.push_back(chunk);
+        }
+
+        char* block = chunk->data() + chunk->used;
+        chunk->used += need;
+        chunk->refs.fetch_add(1);
+        reinterpret_cast<AllocationHeader*>(block)->chunk = chunk;
+        return block + ALIGNMENT;
+    }
+
+    // Rewinds the region. A single chunk with no live allocations is reused as
+    // is; otherwise chunks are retired and replaced by one chunk large enough
+    // for everything this step used, so steady-state steps reuse one chunk.
+    void reset() {
+        if (chunks_.size() == 1 && chunks_[0]->refs.load() == 1) {
+            chunks_[0]->used = 0;
+            return;
+        }
+
+        size_t high_water = 0;
+        for (Chunk* chunk : chunks_) {
+            high_water += chunk->used;
+            release_chunk(chunk);
+        }
+        chunks_.clear();
+        if (high_water > 0) {
+            chunks_.push_back(new_chunk(std::max(high_water, DEFAULT_CHUNK_BYTES)));
+        }
+    }
+
+    size_t reserved_bytes() const {
+        size_t total = 0;
+        for (Chunk* chunk : chunks_) {
+            total += chunk->capacity;
+        }
+        return total;
+    }
+
+private:
+    std::vector<Chunk*> chunks_;
+};
+
+thread_local size_t scope_depth = 0;
+
+Arena& local_arena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+} // namespace
+
+StepArena::StepArena() {
+    ++scope_depth;
+}
+
+StepArena::~StepArena() {
+    if (--scope_depth == 0) {
+        local_arena().reset();
+    }
+}
+
+bool StepArena::active() {
+    return scope_depth > 0;
+}
+
+void* StepArena::allocate(size_t bytes) {
+    assert(active());
+    return local_arena().allocate(bytes);
+}
+
+void StepArena::deallocate(void* ptr) {
+    if (!ptr) return;
+    auto* header = reinterpret_cast<AllocationHeader*>(static_cast<char*>(ptr) - ALIGNMENT);
+    release_chunk(header->chunk);
+}
+
+size_t StepArena::reserved_bytes() {
+    return local_arena().reserved_bytes();
+}
+
+} // namespace core
+} // namespace mtf
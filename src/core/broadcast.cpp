@@ -0,0 +1,108 @@
+#include "core/broadcast.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace mtf {
+namespace core {
+
+namespace {
+
+std::string shape_str(const Tensor::Shape& shape) {
+    std::string s = "(";
+    for (size_t i = 0; i < shape.size(); ++i) {
+        s += std::to_string(shape[i]);
+        if (i + 1 < shape.size()) s += ", ";
+    }
+    return s + ")";
+}
+
+} // namespace
+
+Tensor::Shape broadcast_shapes(const Tensor::Shape& a, const Tensor::Shape& b) {
+    size_t ndim = std::max(a.size(), b.size());
+    Tensor::Shape out(ndim);
+
+    for (size_t i = 0; i < ndim; ++i) {
+        size_t da = i < ndim - a.size() ? 1 : a[i - (ndim - a.size())];
+        size_t db = i < ndim - b.size() ? 1 : b[i - (ndim - b.size())];
+        if (da != db && da != 1 && db != 1) {
+            throw std::invalid_argument("Cannot broadcast shapes " + shape_str(a) +
+                                        " and " + shape_str(b));
+        }
+        out[i] = (da == 1) ? db : da;
+    }
+    return out;
+}
+
+Tensor::Strides broadcast_strides(const Tensor::Shape& shape, const Tensor::Strides& strides,
+                                  const Tensor::Shape& target) {
+    assert(shape.size() <= target.size());
+    size_t lead = target.size() - shape.size();
+    Tensor::Strides out(target.size(), 0);
+
+    for (size_t i = 0; i < shape.size(); ++i) {
+        assert(shape[i] == target[lead + i] || shape[i] == 1);
+        out[lead + i] = (shape[i] == 1) ? 0 : strides[i];
+    }
+    return out;
+}
+
+BroadcastLoop::BroadcastLoop(const Tensor::Shape& shape, std::initializer_list<Tensor::Strides> strides)
+    : num_operands_(strides.size()), size_(1) {
+    assert(num_operands_ > 0 && num_operands_ <= MAX_OPERANDS);
+
+    for (auto dim : shape) {
+        size_ *= dim;
+    }
+
+    std::array<const Tensor::Strides*, MAX_OPERANDS> in{};
+    size_t k = 0;
+    for (const auto& s : strides) {
+        assert(s.size() == shape.size());
+        in[k++] = &s;
+    }
+
+    for (size_t d = 0; d < shape.size(); ++d) {
+        if (shape[d] == 1) continue;
+
+        bool merge = !shape_.empty();
+        for (size_t op = 0; merge && op < num_operands_; ++op) {
+            merge = strides_[op].back() == (*in[op])[d] * shape[d];
+        }
+
+        if (merge) {
+            shape_.back() *= shape[d];
+            for (size_t op = 0; op < num_operands_; ++op) {
+                strides_[op].back() = (*in[op])[d];
+            }
+        } else {
+            shape_.push_back(shape[d]);
+            for (size_t op = 0; op < num_operands_; ++op) {
+                strides_[op].push_back((*in[op])[d]);
+            }
+        }
+    }
+
+    if (shape_.empty()) {
+        shape_.push_back(1);
+        for (size_t op = 0; op < num_operands_; ++op) {
+            strides_[op].push_back(0);
+        }
+    }
+}
+
+void BroadcastLoop::row_offsets(size_t row, size_t* offsets) const {
+    for (size_t k = 0; k < num_operands_; ++k) {
+        offsets[k] = 0;
+    }
+    for (size_t d = shape_.size() - 1; d-- > 0;) {
+        size_t idx = row % shape_[d];
+        row /= shape_[d];
+        for (size_t k = 0; k < num_operands_; ++k) {
+            offsets[k] += idx * strides_[k][d];
+        }
+    }
+}
+
+} // namespace core
+} // namespace mtf
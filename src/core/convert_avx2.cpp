@@ -0,0 +1,83 @@
+#include "core/kernels.hpp"
+
+#if defined(__AVX2__) && (defined(__F16C__) || defined(_MSC_VER))
+#include <immintrin.h>
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+namespace {
+
+inline __m256 bf16_to_float8(__m128i h) {
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+// Round to nearest even on the upper 16 bits; NaNs keep their sign and top
+// payload bits and are made quiet.
+inline __m128i float_to_bf16_8(__m256 x) {
+    const __m256i b = _mm256_castps_si256(x);
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(b, 16), _mm256_set1_epi32(1));
+    __m256i rounded = _mm256_srli_epi32(
+        _mm256_add_epi32(b, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF))), 16);
+    __m256i quiet_nan = _mm256_or_si256(_mm256_srli_epi32(b, 16), _mm256_set1_epi32(0x40));
+    __m256i is_nan = _mm256_castps_si256(_mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+    __m256i r = _mm256_blendv_epi8(rounded, quiet_nan, is_nan);
+    // Pack the eight 32-bit lanes to 16 bits; packus works per 128-bit half.
+    r = _mm256_permute4x64_epi64(_mm256_packus_epi32(r, r), 0x08);
+    return _mm256_castsi256_si128(r);
+}
+
+inline __m128i load8_u16(const uint16_t* x) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(x));
+}
+
+inline void store8_u16(uint16_t* y, __m128i v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y), v);
+}
+
+// Runs op on full blocks of 8 and once more on a zero-padded copy of the tail.
+template <typename In, typename Out, typename Op>
+inline void convert_loop(const In* x, Out* y, size_t n, Op op) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) op(x + i, y + i);
+    if (i < n) {
+        alignas(32) In in[8] = {};
+        alignas(32) Out out[8];
+        for (size_t j = 0; i + j < n; ++j) in[j] = x[i + j];
+        op(in, out);
+        for (size_t j = 0; i + j < n; ++j) y[i + j] = out[j];
+    }
+}
+
+} // namespace
+
+void bf16_to_float_avx2(const uint16_t* x, float* y, size_t n) {
+    convert_loop(x, y, n, [](const uint16_t* in, float* out) {
+        _mm256_storeu_ps(out, bf16_to_float8(load8_u16(in)));
+    });
+}
+
+void float_to_bf16_avx2(const float* x, uint16_t* y, size_t n) {
+    convert_loop(x, y, n, [](const float* in, uint16_t* out) {
+        store8_u16(out, float_to_bf16_8(_mm256_loadu_ps(in)));
+    });
+}
+
+void fp16_to_float_avx2(const uint16_t* x, float* y, size_t n) {
+    convert_loop(x, y, n, [](const uint16_t* in, float* out) {
+        _mm256_storeu_ps(out, _mm256_cvtph_ps(load8_u16(in)));
+    });
+}
+
+void float_to_fp16_avx2(const float* x, uint16_t* y, size_t n) {
+    convert_loop(x, y, n, [](const float* in, uint16_t* out) {
+        store8_u16(out, _mm256_cvtps_ph(_mm256_loadu_ps(in), _MM_FROUND_TO_NEAREST_INT));
+    });
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
+
+#endif
@@ -0,0 +1,150 @@
+#include "core/cpu.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MTF_X86 1
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define MTF_X86 1
+#endif
+
+namespace mtf {
+namespace core {
+
+namespace {
+
+#if defined(MTF_X86)
+
+void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<uint32_t>(out[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+CpuFeatures query_features() {
+    CpuFeatures f;
+    uint32_t regs[4];
+
+    cpuid(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+    if (max_leaf < 1) return f;
+
+    cpuid(1, 0, regs);
+    f.sse42 = (regs[2] >> 20) & 1;
+    f.fma = (regs[2] >> 12) & 1;
+    f.f16c = (regs[2] >> 29) & 1;
+    bool osxsave = (regs[2] >> 27) & 1;
+    if (osxsave) {
+        uint64_t xcr0 = xgetbv0();
+        f.os_ymm = (xcr0 & 0x6) == 0x6;
+        f.os_zmm = f.os_ymm && (xcr0 & 0xe0) == 0xe0;
+    }
+
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        f.avx2 = (regs[1] >> 5) & 1;
+        f.avx512f = (regs[1] >> 16) & 1;
+        f.avx512bw = (regs[1] >> 30) & 1;
+    }
+    return f;
+}
+
+#else
+
+CpuFeatures query_features() {
+    return CpuFeatures();
+}
+
+#endif
+
+Isa compiled_isa() {
+#if defined(MTF_ENABLE_AVX512)
+    return Isa::AVX512;
+#elif defined(MTF_ENABLE_AVX2)
+    return Isa::AVX2;
+#elif defined(MTF_ENABLE_SSE42)
+    return Isa::SSE42;
+#else
+    return Isa::Generic;
+#endif
+}
+
+Isa parse_isa(const char* name, Isa fallback) {
+    const struct { const char* name; Isa isa; } names[] = {
+        {"generic", Isa::Generic}, {"sse4.2", Isa::SSE42}, {"sse42", Isa::SSE42},
+        {"avx2", Isa::AVX2}, {"avx512", Isa::AVX512}
+    };
+    for (const auto& entry : names) {
+        if (std::strcmp(name, entry.name) == 0) return entry.isa;
+    }
+    std::cerr << "MTF_CPU_ISA: unknown instruction set '" << name << "', using "
+              << isa_name(fallback) << std::endl;
+    return fallback;
+}
+
+} // namespace
+
+const CpuFeatures& cpu_features() {
+    static const CpuFeatures features = query_features();
+    return features;
+}
+
+Isa detected_isa() {
+    static const Isa isa = [] {
+        const CpuFeatures& f = cpu_features();
+        Isa best = Isa::Generic;
+        if (f.sse42) best = Isa::SSE42;
+        if (f.avx2 && f.fma && f.f16c && f.os_ymm) best = Isa::AVX2;
+        if (f.avx512f && f.avx512bw && f.avx2 && f.fma && f.f16c && f.os_zmm) best = Isa::AVX512;
+        return best < compiled_isa() ? best : compiled_isa();
+    }();
+    return isa;
+}
+
+Isa active_isa() {
+    static const Isa isa = [] {
+        Isa best = detected_isa();
+        const char* env = std::getenv("MTF_CPU_ISA");
+        if (!env || !*env) return best;
+
+        Isa requested = parse_isa(env, best);
+        if (requested > best) {
+            std::cerr << "MTF_CPU_ISA: " << isa_name(requested) << " is not available, using "
+                      << isa_name(best) << std::endl;
+            return best;
+        }
+        return requested;
+    }();
+    return isa;
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Generic: return "generic";
+        case Isa::SSE42: return "sse4.2";
+        case Isa::AVX2: return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,34 @@
+#include "core/kernels.hpp"
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+namespace {
+
+KernelTable build_table(Isa isa) {
+    KernelTable table = {};
+    table.isa = isa;
+    init_generic_kernels(table);
+#if defined(MTF_ENABLE_SSE42)
+    if (isa >= Isa::SSE42) init_sse42_kernels(table);
+#endif
+#if defined(MTF_ENABLE_AVX2)
+    if (isa >= Isa::AVX2) init_avx2_kernels(table);
+#endif
+#if defined(MTF_ENABLE_AVX512)
+    if (isa >= Isa::AVX512) init_avx512_kernels(table);
+#endif
+    return table;
+}
+
+} // namespace
+
+const KernelTable& table() {
+    static const KernelTable instance = build_table(active_isa());
+    return instance;
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,394 @@
+#include "core/gemm.hpp"
+#include "core/kernels.hpp"
+#include "core/memory.hpp"
+#include "core/thread_pool.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace mtf {
+namespace core {
+
+namespace {
+
+constexpr size_t MR = kernels::GEMM_MR;
+constexpr size_t NR = kernels::GEMM_NR;
+
+// Cache blocking: a KC x NR sliver of B stays in L1, the MC x KC block of
+// packed A in L2 and the KC x NC panel of packed B in L3.
+constexpr size_t MC = 120;
+constexpr size_t KC = 256;
+constexpr size_t NC = 3072;
+
+// Below this much work the threading overhead outweighs the speedup.
+constexpr double MIN_PARALLEL_FLOPS = 4.0 * 1024 * 1024;
+
+struct PackBuffer {
+    float* data = nullptr;
+    size_t capacity = 0;
+
+    ~PackBuffer() {
+        if (data) {
+            aligned_free(data);
+        }
+    }
+
+    float* reserve(size_t count) {
+        if (count > capacity) {
+            if (data) {
+                aligned_free(data);
+            }
+            data = static_cast<float*>(aligned_alloc(count * sizeof(float)));
+            capacity = count;
+        }
+        return data;
+    }
+};
+
+// A matrix operand of any dtype, element (i, p) at i * rs + p * cs.
+struct Operand {
+    const void* data;
+    DType dtype;
+    size_t rs;
+    size_t cs;
+
+    Operand at(size_t i, size_t p) const { return offset(i * rs + p * cs); }
+    Operand offset(size_t elements) const {
+        const char* base = static_cast<const char*>(data);
+        return {base + elements * dtype_size(dtype), dtype, rs, cs};
+    }
+    const float* f32() const { return static_cast<const float*>(data); }
+    const uint16_t* u16() const { return static_cast<const uint16_t*>(data); }
+};
+
+kernels::WidenKernel widen_kernel(DType dtype) {
+    const kernels::KernelTable& k = kernels::table();
+    return dtype == DType::BFloat16 ? k.bf16_to_float : k.fp16_to_float;
+}
+
+// dst[0..n) = src[i * inc] widened to float32, for n <= KC.
+void widen_line(const uint16_t* src, size_t inc, size_t n, kernels::WidenKernel widen, float* dst) {
+    if (inc == 1) {
+        widen(src, dst, n);
+        return;
+    }
+    uint16_t line[KC];
+    for (size_t i = 0; i < n; ++i) line[i] = src[i * inc];
+    widen(line, dst, n);
+}
+
+void pack_a(size_t mc, size_t kc, const float* A, size_t rs, size_t cs, float* out) {
+    for (size_t i = 0; i < mc; i += MR) {
+        size_t rows = std::min(MR, mc - i);
+        const float* src = A + i * rs;
+        for (size_t p = 0; p < kc; ++p) {
+            for (size_t r = 0; r < rows; ++r) {
+                out[r] = src[r * rs + p * cs];
+            }
+            for (size_t r = rows; r < MR; ++r) {
+                out[r] = 0.0f;
+            }
+            out += MR;
+        }
+    }
+}
+
+void pack_b(size_t kc, size_t nc, const float* B, size_t rs, size_t cs, float* out) {
+    for (size_t j = 0; j < nc; j += NR) {
+        size_t cols = std::min(NR, nc - j);
+        const float* src = B + j * cs;
+        for (size_t p = 0; p < kc; ++p) {
+            const float* row = src + p * rs;
+            if (cs == 1) {
+                std::memcpy(out, row, cols * sizeof(float));
+            } else {
+                for (size_t c = 0; c < cols; ++c) {
+                    out[c] = row[c * cs];
+                }
+            }
+            for (size_t c = cols; c < NR; ++c) {
+                out[c] = 0.0f;
+            }
+            out += NR;
+        }
+    }
+}
+
+// 16-bit A is widened MR rows at a time and then packed like float32.
+void pack_a(size_t mc, size_t kc, const Operand& A, float* out) {
+    if (A.dtype == DType::Float32) {
+        pack_a(mc, kc, A.f32(), A.rs, A.cs, out);
+        return;
+    }
+    const kernels::WidenKernel widen = widen_kernel(A.dtype);
+    float rows_f32[MR * KC];
+    for (size_t i = 0; i < mc; i += MR) {
+        size_t rows = std::min(MR, mc - i);
+        for (size_t r = 0; r < rows; ++r) {
+            widen_line(A.at(i + r, 0).u16(), A.cs, kc, widen, rows_f32 + r * kc);
+        }
+        pack_a(rows, kc, rows_f32, kc, 1, out);
+        out += MR * kc;
+    }
+}
+
+void pack_b(size_t kc, size_t nc, const Operand& B, float* out) {
+    if (B.dtype == DType::Float32) {
+        pack_b(kc, nc, B.f32(), B.rs, B.cs, out);
+        return;
+    }
+    const kernels::WidenKernel widen = widen_kernel(B.dtype);
+    for (size_t j = 0; j < nc; j += NR) {
+        size_t cols = std::min(NR, nc - j);
+        for (size_t p = 0; p < kc; ++p) {
+            widen_line(B.at(p, j).u16(), B.cs, cols, widen, out);
+            for (size_t c = cols; c < NR; ++c) {
+                out[c] = 0.0f;
+            }
+            out += NR;
+        }
+    }
+}
+
+// Columns [j0, ...) of a PackedMatrix.
+struct Prepacked {
+    const float* data;
+    size_t ld;
+    size_t j0;
+
+    const float* at(size_t pc, size_t j, size_t kc) const { return data + pc * ld + (j0 + j) * kc; }
+};
+
+// Panels packed per task when building a PackedMatrix.
+constexpr size_t PREPACK_GRAIN = 4;
+
+void scale_c(size_t M, size_t N, float beta, float* C, size_t ldc) {
+    for (size_t i = 0; i < M; ++i) {
+        float* row = C + i * ldc;
+        for (size_t j = 0; j < N; ++j) {
+            row[j] = (beta == 0.0f) ? 0.0f : beta * row[j];
+        }
+    }
+}
+
+void macro_kernel(kernels::GemmMicroKernel ukernel,
+                  size_t mc, size_t nc, size_t kc,
+                  float alpha, const float* packed_a, const float* packed_b,
+                  float beta, float* C, size_t ldc) {
+    alignas(64) float tile[MR * NR];
+
+    for (size_t jr = 0; jr < nc; jr += NR) {
+        size_t nr = std::min(NR, nc - jr);
+        const float* b = packed_b + jr * kc;
+
+        for (size_t ir = 0; ir < mc; ir += MR) {
+            size_t mr = std::min(MR, mc - ir);
+            const float* a = packed_a + ir * kc;
+            float* c = C + ir * ldc + jr;
+
+            if (mr == MR && nr == NR) {
+                ukernel(kc, a, b, c, ldc, alpha, beta);
+                continue;
+            }
+
+            ukernel(kc, a, b, tile, NR, alpha, 0.0f);
+            for (size_t i = 0; i < mr; ++i) {
+                float* c_row = c + i * ldc;
+                const float* t_row = tile + i * NR;
+                if (beta == 0.0f) {
+                    for (size_t j = 0; j < nr; ++j) c_row[j] = t_row[j];
+                } else {
+                    for (size_t j = 0; j < nr; ++j) c_row[j] = t_row[j] + beta * c_row[j];
+                }
+            }
+        }
+    }
+}
+
+// B comes from `prepacked` when it is set and is packed from B otherwise.
+void gemm_block(size_t M, size_t N, size_t K, float alpha,
+                const Operand& A, const Operand& B, const Prepacked* prepacked,
+                float beta, float* C, size_t ldc) {
+    if (M == 0 || N == 0) return;
+    if (K == 0 || alpha == 0.0f) {
+        scale_c(M, N, beta, C, ldc);
+        return;
+    }
+
+    const kernels::GemmMicroKernel ukernel = kernels::table().sgemm_ukernel;
+    thread_local PackBuffer buffer_a;
+    thread_local PackBuffer buffer_b;
+
+    float* packed_a = buffer_a.reserve(MC * KC);
+    float* b_buffer = prepacked ? nullptr : buffer_b.reserve(KC * ((std::min(N, NC) + NR - 1) / NR) * NR);
+
+    for (size_t jc = 0; jc < N; jc += NC) {
+        size_t nc = std::min(NC, N - jc);
+
+        for (size_t pc = 0; pc < K; pc += KC) {
+            size_t kc = std::min(KC, K - pc);
+            float beta_p = (pc == 0) ? beta : 1.0f;
+
+            const float* packed_b = b_buffer;
+            if (prepacked) {
+                packed_b = prepacked->at(pc, jc, kc);
+            } else {
+                pack_b(kc, nc, B.at(pc, jc), b_buffer);
+            }
+
+            for (size_t ic = 0; ic < M; ic += MC) {
+                size_t mc = std::min(MC, M - ic);
+
+                pack_a(mc, kc, A.at(ic, pc), packed_a);
+                macro_kernel(ukernel, mc, nc, kc, alpha, packed_a, packed_b,
+                             beta_p, C + ic * ldc + jc, ldc);
+            }
+        }
+    }
+}
+
+// Runs `batch` products, the b-th with operands and result offset by b times
+// their batch stride, as one set of tasks: each C is split into tiles and the
+// tiles of every product are spread across threads together. B is read from
+// `prepacked` instead of `b` when it is set.
+void gemm_driver(size_t batch, size_t M, size_t N, size_t K, float alpha,
+                 const Operand& a, size_t bs_a, const Operand& b, size_t bs_b,
+                 const PackedMatrix* prepacked,
+                 float beta, float* C, size_t bs_c, size_t ldc) {
+    if (batch == 0 || M == 0 || N == 0) return;
+
+    size_t threads = (2.0 * batch * M * N * K < MIN_PARALLEL_FLOPS) ? 1 : get_num_threads();
+    size_t tiles_wanted = (threads + batch - 1) / batch;
+
+    // Split each C into a grid of at least `tiles_wanted` tiles, cutting
+    // whichever dimension still has more register tiles left.
+    size_t tiles_m = 1;
+    size_t tiles_n = 1;
+    while (tiles_m * tiles_n < tiles_wanted) {
+        size_t m_units = M / tiles_m / MR;
+        size_t n_units = N / tiles_n / NR;
+        if (m_units >= 2 && m_units >= n_units) {
+            ++tiles_m;
+        } else if (n_units >= 2) {
+            ++tiles_n;
+        } else {
+            break;
+        }
+    }
+
+    size_t tile_rows = ((M + tiles_m - 1) / tiles_m + MR - 1) / MR * MR;
+    size_t tile_cols = ((N + tiles_n - 1) / tiles_n + NR - 1) / NR * NR;
+    tiles_m = (M + tile_rows - 1) / tile_rows;
+    tiles_n = (N + tile_cols - 1) / tile_cols;
+
+    const size_t tiles = tiles_m * tiles_n;
+    parallel_for(0, batch * tiles, 1, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            size_t p = t / tiles;
+            size_t i0 = (t % tiles / tiles_n) * tile_rows;
+            size_t j0 = (t % tiles_n) * tile_cols;
+            size_t m = std::min(tile_rows, M - i0);
+            size_t n = std::min(tile_cols, N - j0);
+            Operand a_p = a.offset(p * bs_a);
+            float* c_tile = C + p * bs_c + i0 * ldc + j0;
+            if (prepacked) {
+                const Prepacked source = {prepacked->data(), prepacked->ld(), j0};
+                gemm_block(m, n, K, alpha, a_p.at(i0, 0), b, &source, beta, c_tile, ldc);
+            } else {
+                gemm_block(m, n, K, alpha, a_p.at(i0, 0), b.offset(p * bs_b).at(0, j0), nullptr,
+                           beta, c_tile, ldc);
+            }
+        }
+    });
+}
+
+} // namespace
+
+void sgemm(bool trans_a, bool trans_b,
+           size_t M, size_t N, size_t K,
+           float alpha,
+           const float* A, size_t lda,
+           const float* B, size_t ldb,
+           float beta,
+           float* C, size_t ldc) {
+    sgemm_strided(M, N, K, alpha,
+                  A, trans_a ? 1 : lda, trans_a ? lda : 1,
+                  B, trans_b ? 1 : ldb, trans_b ? ldb : 1,
+                  beta, C, ldc);
+}
+
+void sgemm_strided(size_t M, size_t N, size_t K,
+                   float alpha,
+                   const float* A, size_t rs_a, size_t cs_a,
+                   const float* B, size_t rs_b, size_t cs_b,
+                   float beta,
+                   float* C, size_t ldc) {
+    gemm_strided(M, N, K, alpha,
+                 A, DType::Float32, rs_a, cs_a,
+                 B, DType::Float32, rs_b, cs_b,
+                 beta, C, ldc);
+}
+
+void gemm_strided(size_t M, size_t N, size_t K,
+                  float alpha,
+                  const void* A, DType a_type, size_t rs_a, size_t cs_a,
+                  const void* B, DType b_type, size_t rs_b, size_t cs_b,
+                  float beta,
+                  float* C, size_t ldc) {
+    gemm_driver(1, M, N, K, alpha, {A, a_type, rs_a, cs_a}, 0, {B, b_type, rs_b, cs_b}, 0,
+                nullptr, beta, C, 0, ldc);
+}
+
+void gemm_batched(size_t batch, size_t M, size_t N, size_t K,
+                  float alpha,
+                  const void* A, DType a_type, size_t bs_a, size_t rs_a, size_t cs_a,
+                  const void* B, DType b_type, size_t bs_b, size_t rs_b, size_t cs_b,
+                  float beta,
+                  float* C, size_t bs_c, size_t ldc) {
+    // A shared B, with the rows of A and C running on from one matrix to the
+    // next, is a single product with batch * M rows that packs B only once.
+    if (batch > 1 && bs_b == 0 && bs_a == M * rs_a && bs_c == M * ldc) {
+        M *= batch;
+        batch = 1;
+    }
+    gemm_driver(batch, M, N, K, alpha, {A, a_type, rs_a, cs_a}, bs_a, {B, b_type, rs_b, cs_b}, bs_b,
+                nullptr, beta, C, bs_c, ldc);
+}
+
+PackedMatrix::PackedMatrix(size_t K, size_t N, const void* B, DType dtype, size_t rs, size_t cs)
+    : rows_(K), cols_(N), ld_((N + NR - 1) / NR * NR) {
+    if (K == 0 || N == 0) return;
+    data_ = std::shared_ptr<float>(static_cast<float*>(aligned_alloc(K * ld_ * sizeof(float))),
+                                   aligned_free);
+
+    const Operand b = {B, dtype, rs, cs};
+    const size_t k_blocks = (K + KC - 1) / KC;
+    const size_t panels = ld_ / NR;
+    float* out = data_.get();
+    parallel_for(0, k_blocks * panels, PREPACK_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            size_t pc = (t / panels) * KC;
+            size_t j = (t % panels) * NR;
+            size_t kc = std::min(KC, K - pc);
+            pack_b(kc, std::min(NR, N - j), b.at(pc, j), out + pc * ld_ + j * kc);
+        }
+    });
+}
+
+size_t PackedMatrix::nbytes() const {
+    return data_ ? rows_ * ld_ * sizeof(float) : 0;
+}
+
+void gemm_prepacked(size_t M, size_t N, size_t K,
+                    float alpha,
+                    const void* A, DType a_type, size_t rs_a, size_t cs_a,
+                    const PackedMatrix& B,
+                    float beta,
+                    float* C, size_t ldc) {
+    assert(B.rows() == K && B.cols() == N);
+    gemm_driver(1, M, N, K, alpha, {A, a_type, rs_a, cs_a}, 0, {nullptr, DType::Float32, 0, 0}, 0,
+                &B, beta, C, 0, ldc);
+}
+
+} // namespace core
+} // namespace mtf
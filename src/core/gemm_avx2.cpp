@@ -0,0 +1,72 @@
+#include "core/kernels.hpp"
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+static_assert(GEMM_MR == 6 && GEMM_NR == 16, "AVX2 microkernel is written for a 6x16 tile");
+
+void sgemm_ukernel_avx2(size_t kc, const float* a, const float* b,
+                        float* c, size_t rs_c, float alpha, float beta) {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+    for (size_t p = 0; p < kc; ++p) {
+        __m256 b0 = _mm256_load_ps(b);
+        __m256 b1 = _mm256_load_ps(b + 8);
+        __m256 av;
+
+        av = _mm256_broadcast_ss(a + 0);
+        c00 = _mm256_fmadd_ps(av, b0, c00);
+        c01 = _mm256_fmadd_ps(av, b1, c01);
+        av = _mm256_broadcast_ss(a + 1);
+        c10 = _mm256_fmadd_ps(av, b0, c10);
+        c11 = _mm256_fmadd_ps(av, b1, c11);
+        av = _mm256_broadcast_ss(a + 2);
+        c20 = _mm256_fmadd_ps(av, b0, c20);
+        c21 = _mm256_fmadd_ps(av, b1, c21);
+        av = _mm256_broadcast_ss(a + 3);
+        c30 = _mm256_fmadd_ps(av, b0, c30);
+        c31 = _mm256_fmadd_ps(av, b1, c31);
+        av = _mm256_broadcast_ss(a + 4);
+        c40 = _mm256_fmadd_ps(av, b0, c40);
+        c41 = _mm256_fmadd_ps(av, b1, c41);
+        av = _mm256_broadcast_ss(a + 5);
+        c50 = _mm256_fmadd_ps(av, b0, c50);
+        c51 = _mm256_fmadd_ps(av, b1, c51);
+
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    __m256 acc[GEMM_MR][2] = {
+        {c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}, {c40, c41}, {c50, c51}
+    };
+    __m256 alpha_v = _mm256_set1_ps(alpha);
+    __m256 beta_v = _mm256_set1_ps(beta);
+
+    for (size_t i = 0; i < GEMM_MR; ++i) {
+        float* c_row = c + i * rs_c;
+        __m256 r0 = _mm256_mul_ps(alpha_v, acc[i][0]);
+        __m256 r1 = _mm256_mul_ps(alpha_v, acc[i][1]);
+        if (beta != 0.0f) {
+            r0 = _mm256_fmadd_ps(beta_v, _mm256_loadu_ps(c_row), r0);
+            r1 = _mm256_fmadd_ps(beta_v, _mm256_loadu_ps(c_row + 8), r1);
+        }
+        _mm256_storeu_ps(c_row, r0);
+        _mm256_storeu_ps(c_row + 8, r1);
+    }
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
+
+#endif
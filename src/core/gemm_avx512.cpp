@@ -0,0 +1,76 @@
+#include "core/kernels.hpp"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+static_assert(GEMM_MR == 6 && GEMM_NR == 16, "AVX-512 microkernel is written for a 6x16 tile");
+
+// One zmm covers a row of the tile. Even and odd k steps go to separate
+// accumulators so twelve FMA chains are in flight instead of six.
+void sgemm_ukernel_avx512(size_t kc, const float* a, const float* b,
+                          float* c, size_t rs_c, float alpha, float beta) {
+    __m512 c0 = _mm512_setzero_ps(), d0 = _mm512_setzero_ps();
+    __m512 c1 = _mm512_setzero_ps(), d1 = _mm512_setzero_ps();
+    __m512 c2 = _mm512_setzero_ps(), d2 = _mm512_setzero_ps();
+    __m512 c3 = _mm512_setzero_ps(), d3 = _mm512_setzero_ps();
+    __m512 c4 = _mm512_setzero_ps(), d4 = _mm512_setzero_ps();
+    __m512 c5 = _mm512_setzero_ps(), d5 = _mm512_setzero_ps();
+
+    size_t p = 0;
+    for (; p + 2 <= kc; p += 2) {
+        __m512 b0 = _mm512_load_ps(b);
+        __m512 b1 = _mm512_load_ps(b + GEMM_NR);
+
+        c0 = _mm512_fmadd_ps(_mm512_set1_ps(a[0]), b0, c0);
+        c1 = _mm512_fmadd_ps(_mm512_set1_ps(a[1]), b0, c1);
+        c2 = _mm512_fmadd_ps(_mm512_set1_ps(a[2]), b0, c2);
+        c3 = _mm512_fmadd_ps(_mm512_set1_ps(a[3]), b0, c3);
+        c4 = _mm512_fmadd_ps(_mm512_set1_ps(a[4]), b0, c4);
+        c5 = _mm512_fmadd_ps(_mm512_set1_ps(a[5]), b0, c5);
+
+        d0 = _mm512_fmadd_ps(_mm512_set1_ps(a[6]), b1, d0);
+        d1 = _mm512_fmadd_ps(_mm512_set1_ps(a[7]), b1, d1);
+        d2 = _mm512_fmadd_ps(_mm512_set1_ps(a[8]), b1, d2);
+        d3 = _mm512_fmadd_ps(_mm512_set1_ps(a[9]), b1, d3);
+        d4 = _mm512_fmadd_ps(_mm512_set1_ps(a[10]), b1, d4);
+        d5 = _mm512_fmadd_ps(_mm512_set1_ps(a[11]), b1, d5);
+
+        a += 2 * GEMM_MR;
+        b += 2 * GEMM_NR;
+    }
+    if (p < kc) {
+        __m512 b0 = _mm512_load_ps(b);
+        c0 = _mm512_fmadd_ps(_mm512_set1_ps(a[0]), b0, c0);
+        c1 = _mm512_fmadd_ps(_mm512_set1_ps(a[1]), b0, c1);
+        c2 = _mm512_fmadd_ps(_mm512_set1_ps(a[2]), b0, c2);
+        c3 = _mm512_fmadd_ps(_mm512_set1_ps(a[3]), b0, c3);
+        c4 = _mm512_fmadd_ps(_mm512_set1_ps(a[4]), b0, c4);
+        c5 = _mm512_fmadd_ps(_mm512_set1_ps(a[5]), b0, c5);
+    }
+
+    __m512 acc[GEMM_MR] = {
+        _mm512_add_ps(c0, d0), _mm512_add_ps(c1, d1), _mm512_add_ps(c2, d2),
+        _mm512_add_ps(c3, d3), _mm512_add_ps(c4, d4), _mm512_add_ps(c5, d5)
+    };
+    __m512 alpha_v = _mm512_set1_ps(alpha);
+    __m512 beta_v = _mm512_set1_ps(beta);
+
+    for (size_t i = 0; i < GEMM_MR; ++i) {
+        float* c_row = c + i * rs_c;
+        __m512 r = _mm512_mul_ps(alpha_v, acc[i]);
+        if (beta != 0.0f) {
+            r = _mm512_fmadd_ps(beta_v, _mm512_loadu_ps(c_row), r);
+        }
+        _mm512_storeu_ps(c_row, r);
+    }
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
+
+#endif
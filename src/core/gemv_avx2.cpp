@@ -0,0 +1,55 @@
+#include "core/kernels.hpp"
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+namespace {
+
+// Eight ymm accumulators keep both FMA ports busy while rows of w stream in.
+constexpr int BLOCK_VECS = 8;
+constexpr size_t BLOCK_COLS = 8 * BLOCK_VECS;
+
+} // namespace
+
+void sgemv_avx2(size_t K, size_t n, const float* x, const float* w, size_t ldw, float* y) {
+    size_t j = 0;
+    for (; j + BLOCK_COLS <= n; j += BLOCK_COLS) {
+        __m256 acc[BLOCK_VECS];
+        for (int v = 0; v < BLOCK_VECS; ++v) acc[v] = _mm256_loadu_ps(y + j + 8 * v);
+        const float* row = w + j;
+        for (size_t k = 0; k < K; ++k, row += ldw) {
+            __m256 xk = _mm256_set1_ps(x[k]);
+            for (int v = 0; v < BLOCK_VECS; ++v) {
+                acc[v] = _mm256_fmadd_ps(xk, _mm256_loadu_ps(row + 8 * v), acc[v]);
+            }
+        }
+        for (int v = 0; v < BLOCK_VECS; ++v) _mm256_storeu_ps(y + j + 8 * v, acc[v]);
+    }
+
+    for (; j + 8 <= n; j += 8) {
+        __m256 acc = _mm256_loadu_ps(y + j);
+        const float* row = w + j;
+        for (size_t k = 0; k < K; ++k, row += ldw) {
+            acc = _mm256_fmadd_ps(_mm256_set1_ps(x[k]), _mm256_loadu_ps(row), acc);
+        }
+        _mm256_storeu_ps(y + j, acc);
+    }
+
+    // Fewer than eight columns left.
+    for (; j < n; ++j) {
+        float acc = y[j];
+        const float* col = w + j;
+        for (size_t k = 0; k < K; ++k) acc += x[k] * col[k * ldw];
+        y[j] = acc;
+    }
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
+
+#endif
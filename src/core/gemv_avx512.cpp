@@ -0,0 +1,49 @@
+#include "core/kernels.hpp"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+namespace {
+
+// Eight zmm accumulators keep both FMA ports busy while rows of w stream in.
+constexpr int BLOCK_VECS = 8;
+constexpr size_t BLOCK_COLS = 16 * BLOCK_VECS;
+
+} // namespace
+
+void sgemv_avx512(size_t K, size_t n, const float* x, const float* w, size_t ldw, float* y) {
+    size_t j = 0;
+    for (; j + BLOCK_COLS <= n; j += BLOCK_COLS) {
+        __m512 acc[BLOCK_VECS];
+        for (int v = 0; v < BLOCK_VECS; ++v) acc[v] = _mm512_loadu_ps(y + j + 16 * v);
+        const float* row = w + j;
+        for (size_t k = 0; k < K; ++k, row += ldw) {
+            __m512 xk = _mm512_set1_ps(x[k]);
+            for (int v = 0; v < BLOCK_VECS; ++v) {
+                acc[v] = _mm512_fmadd_ps(xk, _mm512_loadu_ps(row + 16 * v), acc[v]);
+            }
+        }
+        for (int v = 0; v < BLOCK_VECS; ++v) _mm512_storeu_ps(y + j + 16 * v, acc[v]);
+    }
+
+    // Leftover columns, one masked vector at a time.
+    for (; j < n; j += 16) {
+        __mmask16 mask = n - j >= 16 ? 0xffff : static_cast<__mmask16>((1u << (n - j)) - 1);
+        __m512 acc = _mm512_maskz_loadu_ps(mask, y + j);
+        const float* row = w + j;
+        for (size_t k = 0; k < K; ++k, row += ldw) {
+            acc = _mm512_fmadd_ps(_mm512_set1_ps(x[k]), _mm512_maskz_loadu_ps(mask, row), acc);
+        }
+        _mm512_mask_storeu_ps(y + j, mask, acc);
+    }
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
+
+#endif
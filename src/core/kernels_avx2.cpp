@@ -0,0 +1,27 @@
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include "kernels_common.hpp"
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+void init_avx2_kernels(KernelTable& table) {
+    set_common_kernels(table);
+    table.sgemm_ukernel = sgemm_ukernel_avx2;
+    table.qgemm_ukernel = qgemm_ukernel_avx2;
+    table.sgemv = sgemv_avx2;
+    table.exp = vexp_avx2;
+    table.log = vlog_avx2;
+    table.tanh = vtanh_avx2;
+    table.sigmoid = vsigmoid_avx2;
+    table.bf16_to_float = bf16_to_float_avx2;
+    table.float_to_bf16 = float_to_bf16_avx2;
+    table.fp16_to_float = fp16_to_float_avx2;
+    table.float_to_fp16 = float_to_fp16_avx2;
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
+
+#endif
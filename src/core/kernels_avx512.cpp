@@ -0,0 +1,20 @@
+#if defined(__AVX512F__)
+#include "kernels_common.hpp"
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+// Transcendentals and conversions keep the AVX2 versions installed before this.
+void init_avx512_kernels(KernelTable& table) {
+    set_common_kernels(table);
+    table.sgemm_ukernel = sgemm_ukernel_avx512;
+    table.qgemm_ukernel = qgemm_ukernel_avx512;
+    table.sgemv = sgemv_avx512;
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
+
+#endif
@@ -0,0 +1,277 @@
+#pragma once
+
+// Portable kernels written so that the compiler vectorizes them. This header is
+// included by one translation unit per instruction set, each built with its own
+// target flags; everything here has internal linkage so the copies never get
+// merged across those units. Avoid calling library templates (std::max, ...)
+// for the same reason.
+
+#include "core/kernels.hpp"
+#include <cmath>
+
+namespace mtf {
+namespace core {
+namespace kernels {
+namespace {
+
+// One row of the tile at a time keeps the accumulators of that row in vector
+// registers on every target; the B sliver is re-read from L1 for each row.
+void sgemm_ukernel_generic(size_t kc, const float* a, const float* b,
+                           float* c, size_t rs_c, float alpha, float beta) {
+    for (size_t i = 0; i < GEMM_MR; ++i) {
+        float acc[GEMM_NR] = {};
+        for (size_t p = 0; p < kc; ++p) {
+            const float a_val = a[p * GEMM_MR + i];
+            const float* b_row = b + p * GEMM_NR;
+            for (size_t j = 0; j < GEMM_NR; ++j) {
+                acc[j] += a_val * b_row[j];
+            }
+        }
+
+        float* c_row = c + i * rs_c;
+        if (beta == 0.0f) {
+            for (size_t j = 0; j < GEMM_NR; ++j) c_row[j] = alpha * acc[j];
+        } else {
+            for (size_t j = 0; j < GEMM_NR; ++j) c_row[j] = alpha * acc[j] + beta * c_row[j];
+        }
+    }
+}
+
+// Columns per block of the GEMV: the rows of w stream past the block's partial
+// sums once.
+constexpr size_t GEMV_NB = 64;
+
+void sgemv_kernel(size_t K, size_t n, const float* x, const float* w, size_t ldw, float* y) {
+    for (size_t j = 0; j < n; j += GEMV_NB) {
+        const size_t nb = n - j < GEMV_NB ? n - j : GEMV_NB;
+        float acc[GEMV_NB];
+        for (size_t c = 0; c < nb; ++c) acc[c] = y[j + c];
+        const float* row = w + j;
+        for (size_t k = 0; k < K; ++k, row += ldw) {
+            const float xk = x[k];
+            for (size_t c = 0; c < nb; ++c) acc[c] += xk * row[c];
+        }
+        for (size_t c = 0; c < nb; ++c) y[j + c] = acc[c];
+    }
+}
+
+template <typename Op>
+inline void scalar_loop(const float* x, size_t incx, float s, float* y, size_t n, Op op) {
+    if (incx == 1) {
+        for (size_t i = 0; i < n; ++i) y[i] = op(x[i], s);
+    } else {
+        for (size_t i = 0; i < n; ++i) y[i] = op(x[i * incx], s);
+    }
+}
+
+template <typename Op>
+inline void binary_loop(const float* a, size_t inca, const float* b, size_t incb,
+                        float* y, size_t n, Op op) {
+    if (inca == 1 && incb == 1) {
+        for (size_t i = 0; i < n; ++i) y[i] = op(a[i], b[i]);
+    } else if (inca == 1 && incb == 0) {
+        const float b0 = *b;
+        for (size_t i = 0; i < n; ++i) y[i] = op(a[i], b0);
+    } else if (inca == 0 && incb == 1) {
+        const float a0 = *a;
+        for (size_t i = 0; i < n; ++i) y[i] = op(a0, b[i]);
+    } else {
+        for (size_t i = 0; i < n; ++i) y[i] = op(a[i * inca], b[i * incb]);
+    }
+}
+
+// Same NaN behaviour as std::max(x, y).
+inline float max_op(float x, float y) { return x < y ? y : x; }
+
+void add_scalar_kernel(const float* x, size_t incx, float s, float* y, size_t n) {
+    scalar_loop(x, incx, s, y, n, [](float v, float w) { return v + w; });
+}
+
+void mul_scalar_kernel(const float* x, size_t incx, float s, float* y, size_t n) {
+    scalar_loop(x, incx, s, y, n, [](float v, float w) { return v * w; });
+}
+
+void max_scalar_kernel(const float* x, size_t incx, float s, float* y, size_t n) {
+    scalar_loop(x, incx, s, y, n, [](float v, float w) { return max_op(w, v); });
+}
+
+void add_kernel(const float* a, size_t inca, const float* b, size_t incb, float* y, size_t n) {
+    binary_loop(a, inca, b, incb, y, n, [](float v, float w) { return v + w; });
+}
+
+void sub_kernel(const float* a, size_t inca, const float* b, size_t incb, float* y, size_t n) {
+    binary_loop(a, inca, b, incb, y, n, [](float v, float w) { return v - w; });
+}
+
+void mul_kernel(const float* a, size_t inca, const float* b, size_t incb, float* y, size_t n) {
+    binary_loop(a, inca, b, incb, y, n, [](float v, float w) { return v * w; });
+}
+
+void div_kernel(const float* a, size_t inca, const float* b, size_t incb, float* y, size_t n) {
+    binary_loop(a, inca, b, incb, y, n, [](float v, float w) { return v / w; });
+}
+
+void max_kernel(const float* a, size_t inca, const float* b, size_t incb, float* y, size_t n) {
+    binary_loop(a, inca, b, incb, y, n, max_op);
+}
+
+void axpy_kernel(float alpha, const float* x, size_t incx, float* y, size_t n) {
+    if (incx == 1) {
+        for (size_t i = 0; i < n; ++i) y[i] += alpha * x[i];
+    } else if (incx == 0) {
+        const float v = alpha * *x;
+        for (size_t i = 0; i < n; ++i) y[i] += v;
+    } else {
+        for (size_t i = 0; i < n; ++i) y[i] += alpha * x[i * incx];
+    }
+}
+
+void addcmul_kernel(float alpha, const float* a, size_t inca, const float* b, size_t incb,
+                    float* y, size_t n) {
+    if (inca == 1 && incb == 1) {
+        for (size_t i = 0; i < n; ++i) y[i] += alpha * a[i] * b[i];
+    } else if (inca == 1 && incb == 0) {
+        const float s = alpha * *b;
+        for (size_t i = 0; i < n; ++i) y[i] += s * a[i];
+    } else if (inca == 0 && incb == 1) {
+        const float s = alpha * *a;
+        for (size_t i = 0; i < n; ++i) y[i] += s * b[i];
+    } else {
+        for (size_t i = 0; i < n; ++i) y[i] += alpha * a[i * inca] * b[i * incb];
+    }
+}
+
+// Pairwise summation: blocks of PAIRWISE_BLOCK elements are summed in
+// SUM_LANES interleaved partial sums folded pairwise, and blocks are combined by
+// recursive halving, so the error grows with log(n) rather than n. The lane
+// count does not depend on the vector width, so all instruction sets round alike.
+constexpr size_t SUM_LANES = 16;
+constexpr size_t PAIRWISE_BLOCK = 256;
+
+float sum_block(const float* x, size_t n) {
+    float acc[SUM_LANES] = {};
+    size_t i = 0;
+    for (; i + SUM_LANES <= n; i += SUM_LANES) {
+        for (size_t j = 0; j < SUM_LANES; ++j) acc[j] += x[i + j];
+    }
+    for (size_t j = 0; i + j < n; ++j) acc[j] += x[i + j];
+
+    for (size_t width = SUM_LANES / 2; width > 0; width /= 2) {
+        for (size_t j = 0; j < width; ++j) acc[j] += acc[j + width];
+    }
+    return acc[0];
+}
+
+float sum_kernel(const float* x, size_t n) {
+    if (n <= PAIRWISE_BLOCK) {
+        return sum_block(x, n);
+    }
+    size_t half = (n / 2 + PAIRWISE_BLOCK - 1) / PAIRWISE_BLOCK * PAIRWISE_BLOCK;
+    return sum_kernel(x, half) + sum_kernel(x + half, n - half);
+}
+
+// Keeps the first NaN it sees.
+inline float max_nan_op(float acc, float x) { return (x > acc || x != x) ? x : acc; }
+
+float max_reduce_kernel(const float* x, size_t n) {
+    float acc[SUM_LANES];
+    for (size_t j = 0; j < SUM_LANES; ++j) acc[j] = -HUGE_VALF;
+
+    size_t i = 0;
+    for (; i + SUM_LANES <= n; i += SUM_LANES) {
+        for (size_t j = 0; j < SUM_LANES; ++j) acc[j] = max_nan_op(acc[j], x[i + j]);
+    }
+    for (size_t j = 0; i + j < n; ++j) acc[j] = max_nan_op(acc[j], x[i + j]);
+
+    for (size_t width = SUM_LANES / 2; width > 0; width /= 2) {
+        for (size_t j = 0; j < width; ++j) acc[j] = max_nan_op(acc[j], acc[j + width]);
+    }
+    return acc[0];
+}
+
+// Philox runs PHILOX_LANES counters side by side, one per vector lane, so the
+// 32 x 32 -> 64 bit products become vector multiplies.
+constexpr size_t PHILOX_LANES = 16;
+
+inline void philox_round(uint32_t* x0, uint32_t* x1, uint32_t* x2, uint32_t* x3,
+                         uint32_t key0, uint32_t key1) {
+    for (size_t l = 0; l < PHILOX_LANES; ++l) {
+        const uint32_t a = x0[l];
+        const uint32_t c = x2[l];
+        const uint32_t hi0 = static_cast<uint32_t>((static_cast<uint64_t>(a) * 0xD2511F53u) >> 32);
+        const uint32_t hi1 = static_cast<uint32_t>((static_cast<uint64_t>(c) * 0xCD9E8D57u) >> 32);
+        x0[l] = hi1 ^ x1[l] ^ key0;
+        x1[l] = c * 0xCD9E8D57u;
+        x2[l] = hi0 ^ x3[l] ^ key1;
+        x3[l] = a * 0xD2511F53u;
+    }
+}
+
+void philox_kernel(uint64_t first, size_t blocks, uint32_t k0, uint32_t k1, uint32_t* out) {
+    for (size_t b = 0; b < blocks; b += PHILOX_LANES) {
+        uint32_t x0[PHILOX_LANES], x1[PHILOX_LANES], x2[PHILOX_LANES], x3[PHILOX_LANES];
+        for (size_t l = 0; l < PHILOX_LANES; ++l) {
+            const uint64_t c = first + b + l;
+            x0[l] = static_cast<uint32_t>(c);
+            x1[l] = static_cast<uint32_t>(c >> 32);
+            x2[l] = 0;
+            x3[l] = 0;
+        }
+        for (uint32_t round = 0; round < 10; ++round) {
+            philox_round(x0, x1, x2, x3, k0 + round * 0x9E3779B9u, k1 + round * 0xBB67AE85u);
+        }
+        const size_t lanes = blocks - b < PHILOX_LANES ? blocks - b : PHILOX_LANES;
+        uint32_t* dst = out + 4 * b;
+        for (size_t l = 0; l < lanes; ++l) {
+            dst[4 * l] = x0[l];
+            dst[4 * l + 1] = x1[l];
+            dst[4 * l + 2] = x2[l];
+            dst[4 * l + 3] = x3[l];
+        }
+    }
+}
+
+// The angle 2 pi u2 is shifted to [-pi, pi) and folded into [-pi/2, pi/2],
+// where Taylor series to degree 11 and 12 are within an ulp or two; the fold
+// keeps the sine and flips the cosine. Negating both samples of a pair does
+// not change their distribution, so the shift needs no correction.
+void box_muller_kernel(const uint32_t* words, const float* log_u1, size_t pairs, float* out) {
+    const float pi = 3.14159265358979f;
+    for (size_t p = 0; p < pairs; ++p) {
+        const float radius = std::sqrt(-2.0f * log_u1[p]);
+        const float x = static_cast<float>(words[2 * p + 1] >> 8) * (2.0f * pi / 16777216.0f) - pi;
+        const float folded = x > 0.5f * pi ? pi - x : (x < -0.5f * pi ? -pi - x : x);
+        const float sign = folded == x ? 1.0f : -1.0f;
+        const float x2 = folded * folded;
+        const float s = folded * (1.0f + x2 * (-1.0f / 6 + x2 * (1.0f / 120 + x2 * (-1.0f / 5040 +
+                        x2 * (1.0f / 362880 + x2 * (-1.0f / 39916800))))));
+        const float c = 1.0f + x2 * (-0.5f + x2 * (1.0f / 24 + x2 * (-1.0f / 720 + x2 * (1.0f / 40320 +
+                        x2 * (-1.0f / 3628800 + x2 * (1.0f / 479001600))))));
+        out[2 * p] = radius * sign * c;
+        out[2 * p + 1] = radius * s;
+    }
+}
+
+void set_common_kernels(KernelTable& table) {
+    table.sgemm_ukernel = sgemm_ukernel_generic;
+    table.sgemv = sgemv_kernel;
+    table.add_scalar = add_scalar_kernel;
+    table.mul_scalar = mul_scalar_kernel;
+    table.max_scalar = max_scalar_kernel;
+    table.add = add_kernel;
+    table.sub = sub_kernel;
+    table.mul = mul_kernel;
+    table.div = div_kernel;
+    table.max = max_kernel;
+    table.axpy = axpy_kernel;
+    table.addcmul = addcmul_kernel;
+    table.sum = sum_kernel;
+    table.max_reduce = max_reduce_kernel;
+    table.philox = philox_kernel;
+    table.box_muller = box_muller_kernel;
+}
+
+} // namespace
+} // namespace kernels
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,120 @@
+#include "kernels_common.hpp"
+#include "core/vmath.hpp"
+#include <cstring>
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+namespace {
+
+// Portable 16-bit conversions; the AVX2 level replaces them with vector ones.
+
+inline uint32_t float_bits(float x) {
+    uint32_t b;
+    std::memcpy(&b, &x, sizeof(b));
+    return b;
+}
+
+inline float bits_float(uint32_t b) {
+    float x;
+    std::memcpy(&x, &b, sizeof(x));
+    return x;
+}
+
+void bf16_to_float_kernel(const uint16_t* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = bits_float(static_cast<uint32_t>(x[i]) << 16);
+}
+
+void float_to_bf16_kernel(const float* x, uint16_t* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t b = float_bits(x[i]);
+        uint32_t rounded = (b + 0x7FFFu + ((b >> 16) & 1u)) >> 16;
+        uint32_t quiet_nan = (b >> 16) | 0x40u;
+        y[i] = static_cast<uint16_t>((b & 0x7FFFFFFFu) > 0x7F800000u ? quiet_nan : rounded);
+    }
+}
+
+inline float fp16_to_float_one(uint16_t h) {
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1Fu;
+    uint32_t mantissa = h & 0x3FFu;
+    if (exponent == 0) {
+        // Zero or subnormal: mantissa * 2^-24 is exact in float32.
+        return bits_float(sign | float_bits(static_cast<float>(mantissa) * 5.9604644775390625e-8f));
+    }
+    if (exponent == 31) {
+        // Infinity, or a NaN made quiet as the hardware conversions do.
+        uint32_t quiet = mantissa != 0 ? 0x400000u : 0u;
+        return bits_float(sign | 0x7F800000u | quiet | (mantissa << 13));
+    }
+    return bits_float(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+inline uint16_t float_to_fp16_one(float x) {
+    uint32_t b = float_bits(x);
+    uint32_t sign = (b >> 16) & 0x8000u;
+    uint32_t a = b & 0x7FFFFFFFu;
+    if (a > 0x7F800000u) {
+        return static_cast<uint16_t>(sign | 0x7E00u | ((a >> 13) & 0x3FFu));
+    }
+    if (a >= 0x477FF000u) {
+        // At least halfway between 65504 and 65536: rounds to infinity.
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+    if (a < 0x38800000u) {
+        // Below 2^-14 the result is subnormal. Adding 0.5 lines the float32
+        // mantissa up with the binary16 one, so the FPU does the rounding.
+        float t = bits_float(a) + 0.5f;
+        return static_cast<uint16_t>(sign | (float_bits(t) - 0x3F000000u));
+    }
+    // Rebias the exponent from 127 to 15 and round the dropped 13 bits.
+    a += 0xC8000FFFu + ((a >> 13) & 1u);
+    return static_cast<uint16_t>(sign | (a >> 13));
+}
+
+// Portable int8 GEMM tile; the products are exact in int32.
+void qgemm_ukernel_generic(size_t mr, size_t kpairs, const int16_t* a, size_t lda,
+                           const int8_t* b, int32_t* c, size_t ldc) {
+    for (size_t i = 0; i < mr; ++i) {
+        int32_t acc[QGEMM_NR] = {};
+        const int16_t* a_row = a + i * lda;
+        const int8_t* panel = b;
+        for (size_t t = 0; t < kpairs; ++t) {
+            const int32_t a0 = a_row[2 * t];
+            const int32_t a1 = a_row[2 * t + 1];
+            for (size_t j = 0; j < QGEMM_NR; ++j) {
+                acc[j] += a0 * panel[2 * j] + a1 * panel[2 * j + 1];
+            }
+            panel += 2 * QGEMM_NR;
+        }
+        std::memcpy(c + i * ldc, acc, sizeof(acc));
+    }
+}
+
+void fp16_to_float_kernel(const uint16_t* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = fp16_to_float_one(x[i]);
+}
+
+void float_to_fp16_kernel(const float* x, uint16_t* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = float_to_fp16_one(x[i]);
+}
+
+} // namespace
+
+void init_generic_kernels(KernelTable& table) {
+    set_common_kernels(table);
+    table.exp = vmath::reference::exp;
+    table.log = vmath::reference::log;
+    table.tanh = vmath::reference::tanh;
+    table.sigmoid = vmath::reference::sigmoid;
+    table.qgemm_ukernel = qgemm_ukernel_generic;
+    table.bf16_to_float = bf16_to_float_kernel;
+    table.float_to_bf16 = float_to_bf16_kernel;
+    table.fp16_to_float = fp16_to_float_kernel;
+    table.float_to_fp16 = float_to_fp16_kernel;
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
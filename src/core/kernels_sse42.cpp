@@ -0,0 +1,16 @@
+#if defined(__SSE4_2__)
+#include "kernels_common.hpp"
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+void init_sse42_kernels(KernelTable& table) {
+    set_common_kernels(table);
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
+
+#endif
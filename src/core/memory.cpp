@@ -1,14 +1,113 @@
 #include "core/memory.hpp"
+#include "core/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
 
 #if defined(_MSC_VER)
 #include <malloc.h>
 #endif
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace mtf {
 namespace core {
 
-void* aligned_alloc(size_t size, size_t alignment) {
+namespace {
+
+// Size classes: 64, 128, 192, 256, then four evenly spaced classes per power of
+// two (320, 384, 448, 512, 640, ...) up to 256 MiB, so rounding wastes < 25%.
+constexpr size_t MIN_CLASS_BYTES = 64;
+constexpr size_t FIRST_POW2 = 8;
+constexpr size_t LAST_POW2 = 27;
+constexpr size_t NUM_CLASSES = 4 + (LAST_POW2 - FIRST_POW2 + 1) * 4;
+constexpr uint32_t NO_CLASS = ~0u;
+
+constexpr size_t HEADER_BYTES = 64;
+constexpr uint32_t HEADER_MAGIC = 0x6d74663au;
+
+struct BlockHeader {
+    void* base;
+    size_t capacity;
+    size_t mapped_bytes;  // length of the mapping at base, 0 for heap blocks
+    BlockHeader* next;
+    uint32_t size_class;
+    uint32_t magic;
+};
+static_assert(sizeof(BlockHeader) <= HEADER_BYTES, "block header must fit in front of the block");
+
+size_t size_class(size_t size) {
+    if (size <= 4 * MIN_CLASS_BYTES) {
+        return (std::max<size_t>(size, 1) + MIN_CLASS_BYTES - 1) / MIN_CLASS_BYTES - 1;
+    }
+    size_t p = 0;
+    while ((size_t(2) << p) < size) {
+        ++p;
+    }
+    // 2^p < size <= 2^(p+1)
+    size_t step = (size_t(1) << p) / 4;
+    size_t i = (size - (size_t(1) << p) + step - 1) / step;
+    return 4 + (p - FIRST_POW2) * 4 + (i - 1);
+}
+
+size_t class_bytes(size_t cls) {
+    if (cls < 4) {
+        return (cls + 1) * MIN_CLASS_BYTES;
+    }
+    size_t p = FIRST_POW2 + (cls - 4) / 4;
+    size_t i = (cls - 4) % 4 + 1;
+    return (size_t(1) << p) + i * ((size_t(1) << p) / 4);
+}
+
+size_t default_cache_limit() {
+    if (const char* env = std::getenv("MTF_CACHE_LIMIT_MB")) {
+        return static_cast<size_t>(std::strtoull(env, nullptr, 10)) << 20;
+    }
+    return size_t(1) << 30;
+}
+
+size_t default_hugepage_threshold() {
+    if (const char* env = std::getenv("MTF_HUGEPAGE_MB")) {
+        return static_cast<size_t>(std::strtoull(env, nullptr, 10)) << 20;
+    }
+    return size_t(2) << 20;
+}
+
+NumaPolicy default_numa_policy() {
+    const char* env = std::getenv("MTF_NUMA");
+    if (!env || !*env) return NumaPolicy::Default;
+    std::string name(env);
+    if (name == "default") return NumaPolicy::Default;
+    if (name == "first_touch") return NumaPolicy::FirstTouch;
+    if (name == "interleave") return NumaPolicy::Interleave;
+    if (name == "bind") return NumaPolicy::Bind;
+    std::cerr << "MTF_NUMA: unknown policy '" << name << "', using default" << std::endl;
+    return NumaPolicy::Default;
+}
+
+std::atomic<size_t> stat_hits{0};
+std::atomic<size_t> stat_misses{0};
+std::atomic<size_t> stat_system_frees{0};
+std::atomic<size_t> stat_bytes_in_use{0};
+std::atomic<size_t> stat_peak_bytes_in_use{0};
+std::atomic<size_t> stat_bytes_cached{0};
+std::atomic<size_t> cache_limit{default_cache_limit()};
+std::atomic<size_t> hugepage_bytes{default_hugepage_threshold()};
+std::atomic<NumaPolicy> numa{default_numa_policy()};
+
+void* system_alloc(size_t size, size_t alignment) {
+    size = (size + alignment - 1) / alignment * alignment;
 #if defined(_MSC_VER)
     return _aligned_malloc(size, alignment);
 #else
@@ -16,7 +115,7 @@ void* aligned_alloc(size_t size, size_t alignment) {
 #endif
 }
 
-void aligned_free(void* ptr) {
+void system_free(void* ptr) {
 #if defined(_MSC_VER)
     _aligned_free(ptr);
 #else
@@ -24,5 +123,318 @@ void aligned_free(void* ptr) {
 #endif
 }
 
+#if defined(__linux__)
+
+constexpr size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+constexpr size_t SMALL_PAGE_BYTES = 4096;
+
+// mbind(2) modes and the largest node count handled, from <numaif.h>, which
+// would otherwise pull in libnuma.
+constexpr int MPOL_BIND_MODE = 2;
+constexpr int MPOL_INTERLEAVE_MODE = 3;
+constexpr size_t MAX_NODES = 1024;
+constexpr size_t MASK_WORDS = MAX_NODES / (8 * sizeof(unsigned long));
+
+// Nodes listed in /sys/devices/system/node/online, e.g. "0-1,4".
+void online_nodes(unsigned long* mask) {
+    std::memset(mask, 0, MASK_WORDS * sizeof(unsigned long));
+    std::ifstream in("/sys/devices/system/node/online");
+    std::string list;
+    if (!(in >> list)) {
+        mask[0] = 1;
+        return;
+    }
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string range = list.substr(pos, end - pos);
+        size_t dash = range.find('-');
+        size_t first = std::strtoul(range.c_str(), nullptr, 10);
+        size_t last = dash == std::string::npos ? first : std::strtoul(range.c_str() + dash + 1, nullptr, 10);
+        for (size_t node = first; node <= last && node < MAX_NODES; ++node) {
+            mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+        }
+        pos = end + 1;
+    }
+}
+
+void apply_numa_policy(void* start, size_t length, NumaPolicy policy) {
+    unsigned long mask[MASK_WORDS];
+    int mode;
+    if (policy == NumaPolicy::Interleave) {
+        online_nodes(mask);
+        mode = MPOL_INTERLEAVE_MODE;
+    } else if (policy == NumaPolicy::Bind) {
+        // The node of the allocating thread, not of the pool workers.
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || node >= MAX_NODES) return;
+        std::memset(mask, 0, sizeof(mask));
+        mask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+        mode = MPOL_BIND_MODE;
+    } else {
+        return;
+    }
+    // Best effort: kernels without NUMA support fail here and keep the default.
+    syscall(SYS_mbind, start, length, mode, mask, MAX_NODES, 0);
+}
+
+// One write per small page, so every page is backed whether or not the kernel
+// grants huge pages. The pages are split over the thread pool unless `split`
+// is false.
+void first_touch(char* start, size_t length, bool split) {
+    const size_t pages = length / SMALL_PAGE_BYTES;
+    auto touch = [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) start[p * SMALL_PAGE_BYTES] = 0;
+    };
+    if (split) {
+        parallel_for(0, pages, HUGE_PAGE_BYTES / SMALL_PAGE_BYTES, touch);
+    } else {
+        touch(0, pages);
+    }
+}
+
+// Maps length bytes (a multiple of SMALL_PAGE_BYTES) starting on a huge page
+// boundary, by over-mapping and trimming both ends. Only a partial huge page
+// at the end stays on small pages.
+void* map_huge(size_t length) {
+    void* raw = mmap(nullptr, length + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+
+    uintptr_t addr = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t start = (addr + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    size_t head = start - addr;
+    if (head > 0) munmap(raw, head);
+    munmap(reinterpret_cast<char*>(start) + length, HUGE_PAGE_BYTES - head);
+
+    void* block = reinterpret_cast<void*>(start);
+#if defined(MADV_HUGEPAGE)
+    madvise(block, length, MADV_HUGEPAGE);
+#endif
+    NumaPolicy policy = numa.load(std::memory_order_relaxed);
+    apply_numa_policy(block, length, policy);
+    if (policy != NumaPolicy::Default) {
+        // Bind picks the caller's node. The caller touches the pages itself, so
+        // they land there even where mbind is not supported.
+        first_touch(static_cast<char*>(block), length, policy != NumaPolicy::Bind);
+    }
+    return block;
+}
+
+#endif
+
+BlockHeader* header_of(void* ptr) {
+    return reinterpret_cast<BlockHeader*>(static_cast<char*>(ptr) - HEADER_BYTES);
+}
+
+void* payload_of(BlockHeader* header) {
+    return reinterpret_cast<char*>(header) + HEADER_BYTES;
+}
+
+BlockHeader* allocate_block(size_t capacity, size_t alignment, uint32_t cls) {
+    size_t offset = std::max(HEADER_BYTES, alignment);
+    void* base = nullptr;
+    size_t mapped_bytes = 0;
+#if defined(__linux__)
+    size_t threshold = hugepage_bytes.load(std::memory_order_relaxed);
+    if (threshold > 0 && capacity >= threshold && alignment <= HUGE_PAGE_BYTES) {
+        mapped_bytes = (offset + capacity + SMALL_PAGE_BYTES - 1) / SMALL_PAGE_BYTES * SMALL_PAGE_BYTES;
+        base = map_huge(mapped_bytes);
+        if (!base) mapped_bytes = 0;
+    }
+#endif
+    if (!base) base = system_alloc(offset + capacity, alignment);
+    if (!base) return nullptr;
+
+    stat_misses.fetch_add(1, std::memory_order_relaxed);
+    auto* header = reinterpret_cast<BlockHeader*>(static_cast<char*>(base) + offset - HEADER_BYTES);
+    header->base = base;
+    header->capacity = capacity;
+    header->mapped_bytes = mapped_bytes;
+    header->next = nullptr;
+    header->size_class = cls;
+    header->magic = HEADER_MAGIC;
+    return header;
+}
+
+void release_block(BlockHeader* header) {
+    stat_system_frees.fetch_add(1, std::memory_order_relaxed);
+#if defined(__linux__)
+    if (header->mapped_bytes > 0) {
+        munmap(header->base, header->mapped_bytes);
+        return;
+    }
+#endif
+    system_free(header->base);
+}
+
+void track_in_use(size_t bytes) {
+    size_t now = stat_bytes_in_use.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = stat_peak_bytes_in_use.load(std::memory_order_relaxed);
+    while (now > peak &&
+           !stat_peak_bytes_in_use.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+    }
+}
+
+struct ThreadCache;
+
+struct CacheRegistry {
+    std::mutex mutex;
+    std::vector<ThreadCache*> caches;
+};
+
+// Intentionally leaked: worker threads may still exit (and drain their caches)
+// while static objects are being destroyed.
+CacheRegistry& registry() {
+    static CacheRegistry* instance = new CacheRegistry();
+    return *instance;
+}
+
+struct ThreadCache {
+    std::mutex mutex;
+    BlockHeader* free_lists[NUM_CLASSES] = {};
+
+    ThreadCache() {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().caches.push_back(this);
+    }
+
+    ~ThreadCache();
+
+    void release_all() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& head : free_lists) {
+            while (head) {
+                BlockHeader* block = head;
+                head = block->next;
+                stat_bytes_cached.fetch_sub(block->capacity, std::memory_order_relaxed);
+                release_block(block);
+            }
+        }
+    }
+};
+
+// Trivially destructible, so it stays readable while other thread_local
+// objects (e.g. GEMM pack buffers) free their memory during thread exit.
+thread_local bool cache_destroyed = false;
+
+ThreadCache::~ThreadCache() {
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        auto& caches = registry().caches;
+        caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+    }
+    release_all();
+    cache_destroyed = true;
+}
+
+ThreadCache* local_cache() {
+    if (cache_destroyed) return nullptr;
+    thread_local ThreadCache cache;
+    return &cache;
+}
+
+} // namespace
+
+void* aligned_alloc(size_t size, size_t alignment) {
+    if (alignment > HEADER_BYTES || size > class_bytes(NUM_CLASSES - 1)) {
+        BlockHeader* header = allocate_block(size, alignment, NO_CLASS);
+        if (!header) return nullptr;
+        track_in_use(header->capacity);
+        return payload_of(header);
+    }
+
+    size_t cls = size_class(size);
+    ThreadCache* cache = local_cache();
+    if (cache) {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        if (BlockHeader* block = cache->free_lists[cls]) {
+            cache->free_lists[cls] = block->next;
+            block->next = nullptr;
+            stat_bytes_cached.fetch_sub(block->capacity, std::memory_order_relaxed);
+            stat_hits.fetch_add(1, std::memory_order_relaxed);
+            track_in_use(block->capacity);
+            return payload_of(block);
+        }
+    }
+
+    BlockHeader* header = allocate_block(class_bytes(cls), HEADER_BYTES, static_cast<uint32_t>(cls));
+    if (!header) return nullptr;
+    track_in_use(header->capacity);
+    return payload_of(header);
+}
+
+void aligned_free(void* ptr) {
+    if (!ptr) return;
+
+    BlockHeader* header = header_of(ptr);
+    assert(header->magic == HEADER_MAGIC);
+    stat_bytes_in_use.fetch_sub(header->capacity, std::memory_order_relaxed);
+
+    ThreadCache* cache = header->size_class != NO_CLASS ? local_cache() : nullptr;
+    if (cache) {
+        size_t cached = stat_bytes_cached.fetch_add(header->capacity, std::memory_order_relaxed);
+        if (cached + header->capacity <= cache_limit.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            header->next = cache->free_lists[header->size_class];
+            cache->free_lists[header->size_class] = header;
+            return;
+        }
+        stat_bytes_cached.fetch_sub(header->capacity, std::memory_order_relaxed);
+    }
+    release_block(header);
+}
+
+AllocatorStats allocator_stats() {
+    AllocatorStats stats;
+    stats.hits = stat_hits.load();
+    stats.misses = stat_misses.load();
+    stats.system_frees = stat_system_frees.load();
+    stats.bytes_in_use = stat_bytes_in_use.load();
+    stats.peak_bytes_in_use = stat_peak_bytes_in_use.load();
+    stats.bytes_cached = stat_bytes_cached.load();
+    stats.cache_limit = cache_limit.load();
+    return stats;
+}
+
+void reset_allocator_stats() {
+    stat_hits.store(0);
+    stat_misses.store(0);
+    stat_system_frees.store(0);
+    stat_peak_bytes_in_use.store(stat_bytes_in_use.load());
+}
+
+void empty_cache() {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    for (ThreadCache* cache : registry().caches) {
+        cache->release_all();
+    }
+}
+
+void set_cache_limit(size_t bytes) {
+    cache_limit.store(bytes);
+    if (stat_bytes_cached.load() > bytes) {
+        empty_cache();
+    }
+}
+
+void set_hugepage_threshold(size_t bytes) {
+    hugepage_bytes.store(bytes);
+}
+
+size_t hugepage_threshold() {
+    return hugepage_bytes.load();
+}
+
+void set_numa_policy(NumaPolicy policy) {
+    numa.store(policy);
+}
+
+NumaPolicy numa_policy() {
+    return numa.load();
+}
+
 } // namespace core
 } // namespace mtf
@@ -1,178 +1,641 @@
 #include "core/ops_cpu.hpp"
+#include "core/broadcast.hpp"
+#include "core/gemm.hpp"
+#include "core/kernels.hpp"
+#include "core/thread_pool.hpp"
 #include <cmath>
 #include <algorithm>
-#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace mtf {
 namespace core {
 namespace ops {
 
-Tensor add(const Tensor& a, const Tensor& b) {
-    if (a.shape().size() == 2 && b.shape().size() == 2 &&
-        a.shape()[0] != b.shape()[0] && b.shape()[0] == 1 &&
-        a.shape()[1] == b.shape()[1]) {
-        Tensor result(a.shape());
-        size_t M = a.shape()[0];
-        size_t N = a.shape()[1];
-        const float* a_ptr = a.data();
-        const float* b_ptr = b.data();
-        float* r_ptr = result.data();
-        
-        for (size_t i = 0; i < M; ++i) {
-            for (size_t j = 0; j < N; ++j) {
-                r_ptr[i * N + j] = a_ptr[i * N + j] + b_ptr[j];
-            }
-        }
-        return result;
+namespace {
+
+// Minimum elements per thread: cheap arithmetic needs bigger chunks than
+// transcendental functions before threading pays off.
+constexpr size_t ELEMENTWISE_GRAIN = 32768;
+constexpr size_t TRANSCENDENTAL_GRAIN = 4096;
+
+// Output columns per GEMV task, and multiply-adds per task before threading
+// pays off.
+constexpr size_t GEMV_COLS = 256;
+constexpr size_t GEMV_GRAIN = 1 << 18;
+
+// op(t) for a 2-D or 3-D t as a batch of matrices; bs is 0 unless the batch
+// has more than one matrix.
+struct BatchOperand {
+    size_t batch;
+    size_t rows;
+    size_t cols;
+    size_t bs;
+    size_t rs;
+    size_t cs;
+};
+
+BatchOperand batch_operand(const Tensor& t, bool trans, const char* name) {
+    const size_t rank = t.shape().size();
+    if (rank != 2 && rank != 3) {
+        throw std::invalid_argument(std::string("bmm: ") + name + " must be 2-D or 3-D");
     }
-    
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = a[i] + b[i];
+    const size_t r = rank - 2;
+    const size_t c = rank - 1;
+    BatchOperand op;
+    op.batch = rank == 3 ? t.shape()[0] : 1;
+    op.bs = op.batch > 1 ? t.strides()[0] : 0;
+    op.rows = t.shape()[trans ? c : r];
+    op.cols = t.shape()[trans ? r : c];
+    op.rs = t.strides()[trans ? c : r];
+    op.cs = t.strides()[trans ? r : c];
+    return op;
+}
+
+void check_matrix(const Tensor& t, const char* op, const char* name) {
+    if (t.shape().size() != 2) {
+        throw std::invalid_argument(std::string(op) + ": " + name + " must be 2-D");
     }
-    return result;
 }
 
-Tensor sub(const Tensor& a, const Tensor& b) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = a[i] - b[i];
+void check_inner(size_t k_a, size_t k_b, const char* op) {
+    if (k_a != k_b) {
+        throw std::invalid_argument(std::string(op) + ": inner dimensions differ (" +
+                                    std::to_string(k_a) + " vs " + std::to_string(k_b) + ")");
     }
-    return result;
 }
 
-Tensor mul(const Tensor& a, const Tensor& b) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = a[i] * b[i];
+// Throws unless c is a float32 [M, N] matrix with unit column stride.
+void check_gemm_out(const Tensor& c, size_t M, size_t N, const char* op) {
+    if (c.shape().size() != 2 || c.shape()[0] != M || c.shape()[1] != N) {
+        throw std::invalid_argument(std::string(op) + ": output has the wrong shape");
+    }
+    if (c.dtype() != DType::Float32 || (N > 1 && c.strides()[1] != 1)) {
+        throw std::invalid_argument(std::string(op) + ": output must be float32 with contiguous rows");
     }
-    return result;
 }
 
-Tensor div(const Tensor& a, const Tensor& b) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = a[i] / b[i];
+void activate(float* y, size_t n, Activation act) {
+    const kernels::KernelTable& k = kernels::table();
+    switch (act) {
+        case Activation::Relu: k.max_scalar(y, 1, 0.0f, y, n); break;
+        case Activation::Sigmoid: k.sigmoid(y, y, n); break;
+        case Activation::Tanh: k.tanh(y, y, n); break;
+        case Activation::None: break;
     }
-    return result;
 }
 
-Tensor add_scalar(const Tensor& a, float scalar) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = a[i] + scalar;
+// Elements converted at a time when an operand is stored in 16 bits.
+constexpr size_t CONVERT_BLOCK = 1024;
+
+kernels::WidenKernel widen_kernel(DType dtype) {
+    const kernels::KernelTable& k = kernels::table();
+    return dtype == DType::BFloat16 ? k.bf16_to_float : k.fp16_to_float;
+}
+
+kernels::NarrowKernel narrow_kernel(DType dtype) {
+    const kernels::KernelTable& k = kernels::table();
+    return dtype == DType::BFloat16 ? k.float_to_bf16 : k.float_to_fp16;
+}
+
+// Returns n elements of t from `offset`, inc apart, as float32. Float32 data is
+// read in place; 16-bit data is widened into buf (CONVERT_BLOCK floats) and inc
+// becomes 1, or stays 0 for a broadcast value.
+const float* read_f32(const Tensor& t, size_t offset, size_t& inc, size_t n, float* buf) {
+    if (t.dtype() == DType::Float32) {
+        return t.data() + offset;
     }
-    return result;
+    const uint16_t* src = static_cast<const uint16_t*>(t.raw_data()) + offset;
+    const kernels::WidenKernel widen = widen_kernel(t.dtype());
+    if (inc <= 1) {
+        widen(src, buf, inc == 0 ? 1 : n);
+        return buf;
+    }
+    uint16_t line[CONVERT_BLOCK];
+    for (size_t i = 0; i < n; ++i) line[i] = src[i * inc];
+    widen(line, buf, n);
+    inc = 1;
+    return buf;
 }
 
-Tensor mul_scalar(const Tensor& a, float scalar) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = a[i] * scalar;
+// Float32 destination for n elements from `offset` of a contiguous tensor
+// whose storage starts at base: the tensor itself, or buf for 16-bit tensors,
+// to be narrowed back by write_f32. base is taken once per call, outside the
+// loops, since every mutable access bumps the tensor's version.
+float* write_ptr(void* base, DType dtype, size_t offset, float* buf) {
+    return dtype == DType::Float32 ? static_cast<float*>(base) + offset : buf;
+}
+
+void write_f32(void* base, DType dtype, size_t offset, const float* buf, size_t n) {
+    if (dtype != DType::Float32) {
+        narrow_kernel(dtype)(buf, static_cast<uint16_t*>(base) + offset, n);
     }
-    return result;
 }
 
-Tensor matmul(const Tensor& a, const Tensor& b) {
-    size_t M = a.shape()[0];
-    size_t K = a.shape()[1];
-    size_t N = b.shape()[1];
+// Throws unless out is contiguous with the given shape.
+void check_out(const Tensor& out, const Tensor::Shape& shape, const char* op) {
+    if (out.shape() != shape) {
+        throw std::invalid_argument(std::string(op) + ": out does not have the result shape");
+    }
+    if (!out.is_contiguous()) {
+        throw std::invalid_argument(std::string(op) + ": out must be contiguous");
+    }
+}
+
+// Writes y = f(x, s) over a, which may be strided, into out, which is
+// contiguous with a's shape and may be a itself.
+void scalar_into(const Tensor& a, float scalar, Tensor& out, kernels::ScalarKernel kernel) {
+    if (a.dtype() != DType::Float32 || out.dtype() != DType::Float32) {
+        BroadcastLoop loop(out.shape(), {out.strides(), a.strides()});
+        const size_t sa = loop.inner_stride(1);
+        void* out_base = out.raw_data();
+        parallel_for(0, a.size(), ELEMENTWISE_GRAIN, [&](size_t begin, size_t end) {
+            float a_buf[CONVERT_BLOCK];
+            float r_buf[CONVERT_BLOCK];
+            loop.for_each_run(begin, end, [&](const size_t* off, size_t count) {
+                for (size_t i = 0; i < count; i += CONVERT_BLOCK) {
+                    size_t n = std::min(CONVERT_BLOCK, count - i);
+                    size_t inc = sa;
+                    const float* x = read_f32(a, off[1] + i * sa, inc, n, a_buf);
+                    float* y = write_ptr(out_base, out.dtype(), off[0] + i, r_buf);
+                    kernel(x, inc, scalar, y, n);
+                    write_f32(out_base, out.dtype(), off[0] + i, y, n);
+                }
+            });
+        });
+        return;
+    }
 
-    assert(a.shape()[1] == b.shape()[0]);
+    const float* a_ptr = a.data();
+    float* r_ptr = out.data();
 
-    Tensor result({M, N});
-    result.fill(0.0f);
+    if (a.is_contiguous()) {
+        parallel_for(0, a.size(), ELEMENTWISE_GRAIN, [&](size_t begin, size_t end) {
+            kernel(a_ptr + begin, 1, scalar, r_ptr + begin, end - begin);
+        });
+        return;
+    }
+
+    BroadcastLoop loop(out.shape(), {out.strides(), a.strides()});
+    const size_t sa = loop.inner_stride(1);
+    parallel_for(0, a.size(), ELEMENTWISE_GRAIN, [&](size_t begin, size_t end) {
+        loop.for_each_run(begin, end, [&](const size_t* off, size_t count) {
+            kernel(a_ptr + off[1], sa, scalar, r_ptr + off[0], count);
+        });
+    });
+}
+
+Tensor scalar_op(const Tensor& a, float scalar, kernels::ScalarKernel kernel) {
+    Tensor result(a.shape(), a.dtype());
+    scalar_into(a, scalar, result, kernel);
+    return result;
+}
 
-    const float* A_ptr = a.data();
-    const float* B_ptr = b.data();
-    float* C_ptr = result.data();
+// Applies a contiguous-only kernel into out, which is contiguous with a's
+// shape and may be a itself; a is packed first if it is strided.
+void array_into(const Tensor& a, Tensor& out, kernels::UnaryKernel kernel) {
+    Tensor src = a.contiguous();
 
-    for (size_t i = 0; i < M; ++i) {
-        for (size_t k = 0; k < K; ++k) {
-            float val_a = A_ptr[i * K + k];
-            for (size_t j = 0; j < N; ++j) {
-                C_ptr[i * N + j] += val_a * B_ptr[k * N + j];
+    if (a.dtype() != DType::Float32 || out.dtype() != DType::Float32) {
+        void* out_base = out.raw_data();
+        parallel_for(0, a.size(), TRANSCENDENTAL_GRAIN, [&](size_t begin, size_t end) {
+            float a_buf[CONVERT_BLOCK];
+            float r_buf[CONVERT_BLOCK];
+            for (size_t i = begin; i < end; i += CONVERT_BLOCK) {
+                size_t n = std::min(CONVERT_BLOCK, end - i);
+                size_t inc = 1;
+                const float* x = read_f32(src, i, inc, n, a_buf);
+                float* y = write_ptr(out_base, out.dtype(), i, r_buf);
+                kernel(x, y, n);
+                write_f32(out_base, out.dtype(), i, y, n);
             }
-        }
+        });
+        return;
     }
+
+    const float* a_ptr = src.data();
+    float* r_ptr = out.data();
+
+    parallel_for(0, a.size(), TRANSCENDENTAL_GRAIN, [&](size_t begin, size_t end) {
+        kernel(a_ptr + begin, r_ptr + begin, end - begin);
+    });
+}
+
+Tensor array_op(const Tensor& a, kernels::UnaryKernel kernel) {
+    Tensor result(a.shape(), a.dtype());
+    array_into(a, result, kernel);
     return result;
 }
 
-Tensor transpose(const Tensor& a) {
-    size_t rows = a.shape()[0];
-    size_t cols = a.shape()[1];
-    Tensor result({cols, rows});
-    
-    for (size_t i = 0; i < rows; ++i) {
-        for (size_t j = 0; j < cols; ++j) {
-            result[j * rows + i] = a[i * cols + j];
-        }
+// Writes f(a, b) into out, which is contiguous with the broadcast shape and may
+// be one of the operands.
+void binary_into(const Tensor& a, const Tensor& b, Tensor& out, kernels::BinaryKernel kernel) {
+    BroadcastLoop loop(out.shape(), {
+        out.strides(),
+        broadcast_strides(a.shape(), a.strides(), out.shape()),
+        broadcast_strides(b.shape(), b.strides(), out.shape())
+    });
+    const size_t sa = loop.inner_stride(1);
+    const size_t sb = loop.inner_stride(2);
+
+    if (a.dtype() != DType::Float32 || b.dtype() != DType::Float32 || out.dtype() != DType::Float32) {
+        void* out_base = out.raw_data();
+        parallel_for(0, out.size(), ELEMENTWISE_GRAIN, [&](size_t begin, size_t end) {
+            float a_buf[CONVERT_BLOCK];
+            float b_buf[CONVERT_BLOCK];
+            float r_buf[CONVERT_BLOCK];
+            loop.for_each_run(begin, end, [&](const size_t* off, size_t count) {
+                for (size_t i = 0; i < count; i += CONVERT_BLOCK) {
+                    size_t n = std::min(CONVERT_BLOCK, count - i);
+                    size_t inc_a = sa;
+                    size_t inc_b = sb;
+                    const float* x = read_f32(a, off[1] + i * sa, inc_a, n, a_buf);
+                    const float* y = read_f32(b, off[2] + i * sb, inc_b, n, b_buf);
+                    float* r = write_ptr(out_base, out.dtype(), off[0] + i, r_buf);
+                    kernel(x, inc_a, y, inc_b, r, n);
+                    write_f32(out_base, out.dtype(), off[0] + i, r, n);
+                }
+            });
+        });
+        return;
     }
+
+    const float* a_ptr = a.data();
+    const float* b_ptr = b.data();
+    float* r_ptr = out.data();
+
+    parallel_for(0, out.size(), ELEMENTWISE_GRAIN, [&](size_t begin, size_t end) {
+        loop.for_each_run(begin, end, [&](const size_t* off, size_t count) {
+            kernel(a_ptr + off[1], sa, b_ptr + off[2], sb, r_ptr + off[0], count);
+        });
+    });
+}
+
+// The result keeps the operands' dtype when they share one and is float32
+// otherwise.
+Tensor binary_op(const Tensor& a, const Tensor& b, kernels::BinaryKernel kernel) {
+    DType dtype = a.dtype() == b.dtype() ? a.dtype() : DType::Float32;
+    Tensor result(broadcast_shapes(a.shape(), b.shape()), dtype);
+    binary_into(a, b, result, kernel);
     return result;
 }
 
-Tensor sum(const Tensor& a) {
-    float s = 0.0f;
-    for (size_t i = 0; i < a.size(); ++i) {
-        s += a[i];
+void binary_out(const Tensor& a, const Tensor& b, Tensor& out, kernels::BinaryKernel kernel, const char* op) {
+    check_out(out, broadcast_shapes(a.shape(), b.shape()), op);
+    binary_into(a, b, out, kernel);
+}
+
+// y += alpha * a, or y += alpha * a * b when b is given, with the operands
+// broadcast to y, which is contiguous.
+void accumulate_into(Tensor& y, float alpha, const Tensor& a, const Tensor* b) {
+    const Tensor& b_ref = b ? *b : a;
+    BroadcastLoop loop(y.shape(), {
+        y.strides(),
+        broadcast_strides(a.shape(), a.strides(), y.shape()),
+        broadcast_strides(b_ref.shape(), b_ref.strides(), y.shape())
+    });
+    const size_t sa = loop.inner_stride(1);
+    const size_t sb = loop.inner_stride(2);
+    const kernels::KernelTable& k = kernels::table();
+    auto update = [&](const float* x, size_t inc_x, const float* z, size_t inc_z, float* dst, size_t n) {
+        if (b) {
+            k.addcmul(alpha, x, inc_x, z, inc_z, dst, n);
+        } else {
+            k.axpy(alpha, x, inc_x, dst, n);
+        }
+    };
+
+    if (a.dtype() != DType::Float32 || b_ref.dtype() != DType::Float32 || y.dtype() != DType::Float32) {
+        void* y_base = y.raw_data();
+        parallel_for(0, y.size(), ELEMENTWISE_GRAIN, [&](size_t begin, size_t end) {
+            float a_buf[CONVERT_BLOCK];
+            float b_buf[CONVERT_BLOCK];
+            float y_buf[CONVERT_BLOCK];
+            loop.for_each_run(begin, end, [&](const size_t* off, size_t count) {
+                for (size_t i = 0; i < count; i += CONVERT_BLOCK) {
+                    size_t n = std::min(CONVERT_BLOCK, count - i);
+                    size_t inc_a = sa;
+                    size_t inc_b = sb;
+                    size_t inc_y = 1;
+                    const float* x = read_f32(a, off[1] + i * sa, inc_a, n, a_buf);
+                    const float* z = read_f32(b_ref, off[2] + i * sb, inc_b, n, b_buf);
+                    float* dst = write_ptr(y_base, y.dtype(), off[0] + i, y_buf);
+                    if (y.dtype() != DType::Float32) read_f32(y, off[0] + i, inc_y, n, y_buf);
+                    update(x, inc_a, z, inc_b, dst, n);
+                    write_f32(y_base, y.dtype(), off[0] + i, dst, n);
+                }
+            });
+        });
+        return;
     }
-    Tensor result({1});
-    result[0] = s;
+
+    const float* a_ptr = a.data();
+    const float* b_ptr = b_ref.data();
+    float* y_ptr = y.data();
+
+    parallel_for(0, y.size(), ELEMENTWISE_GRAIN, [&](size_t begin, size_t end) {
+        loop.for_each_run(begin, end, [&](const size_t* off, size_t count) {
+            update(a_ptr + off[1], sa, b_ptr + off[2], sb, y_ptr + off[0], count);
+        });
+    });
+}
+
+} // namespace
+
+Tensor add(const Tensor& a, const Tensor& b) {
+    return binary_op(a, b, kernels::table().add);
+}
+
+Tensor sub(const Tensor& a, const Tensor& b) {
+    return binary_op(a, b, kernels::table().sub);
+}
+
+Tensor mul(const Tensor& a, const Tensor& b) {
+    return binary_op(a, b, kernels::table().mul);
+}
+
+Tensor div(const Tensor& a, const Tensor& b) {
+    return binary_op(a, b, kernels::table().div);
+}
+
+Tensor add_scalar(const Tensor& a, float scalar) {
+    return scalar_op(a, scalar, kernels::table().add_scalar);
+}
+
+Tensor mul_scalar(const Tensor& a, float scalar) {
+    return scalar_op(a, scalar, kernels::table().mul_scalar);
+}
+
+void add(const Tensor& a, const Tensor& b, Tensor& out) {
+    binary_out(a, b, out, kernels::table().add, "add");
+}
+
+void sub(const Tensor& a, const Tensor& b, Tensor& out) {
+    binary_out(a, b, out, kernels::table().sub, "sub");
+}
+
+void mul(const Tensor& a, const Tensor& b, Tensor& out) {
+    binary_out(a, b, out, kernels::table().mul, "mul");
+}
+
+void div(const Tensor& a, const Tensor& b, Tensor& out) {
+    binary_out(a, b, out, kernels::table().div, "div");
+}
+
+void mul_scalar(const Tensor& a, float scalar, Tensor& out) {
+    check_out(out, a.shape(), "mul_scalar");
+    scalar_into(a, scalar, out, kernels::table().mul_scalar);
+}
+
+void add_(Tensor& a, const Tensor& b) {
+    binary_out(a, b, a, kernels::table().add, "add_");
+}
+
+void sub_(Tensor& a, const Tensor& b) {
+    binary_out(a, b, a, kernels::table().sub, "sub_");
+}
+
+void mul_(Tensor& a, const Tensor& b) {
+    binary_out(a, b, a, kernels::table().mul, "mul_");
+}
+
+void mul_scalar_(Tensor& a, float scalar) {
+    mul_scalar(a, scalar, a);
+}
+
+void axpy(float alpha, const Tensor& x, Tensor& y) {
+    check_out(y, broadcast_shapes(y.shape(), x.shape()), "axpy");
+    accumulate_into(y, alpha, x, nullptr);
+}
+
+void addcmul_(Tensor& out, const Tensor& a, const Tensor& b, float alpha) {
+    check_out(out, broadcast_shapes(out.shape(), broadcast_shapes(a.shape(), b.shape())), "addcmul_");
+    accumulate_into(out, alpha, a, &b);
+}
+
+Tensor matmul(const Tensor& a, const Tensor& b) {
+    check_matrix(a, "matmul", "a");
+    check_matrix(b, "matmul", "b");
+    check_inner(a.shape()[1], b.shape()[0], "matmul");
+
+    Tensor result({a.shape()[0], b.shape()[1]});
+    gemm(false, false, 1.0f, a, b, 0.0f, result);
     return result;
 }
 
-Tensor mean(const Tensor& a) {
-    Tensor s = sum(a);
-    s[0] /= static_cast<float>(a.size());
-    return s;
+void gemm(bool trans_a, bool trans_b, float alpha,
+          const Tensor& a, const Tensor& b, float beta, Tensor& c) {
+    check_matrix(a, "gemm", "a");
+    check_matrix(b, "gemm", "b");
+    size_t M = trans_a ? a.shape()[1] : a.shape()[0];
+    size_t K = trans_a ? a.shape()[0] : a.shape()[1];
+    size_t N = trans_b ? b.shape()[0] : b.shape()[1];
+
+    check_inner(K, trans_b ? b.shape()[1] : b.shape()[0], "gemm");
+    check_gemm_out(c, M, N, "gemm");
+
+    // Operands may be strided views; transposition just swaps their strides.
+    size_t rs_a = a.strides()[trans_a ? 1 : 0];
+    size_t cs_a = a.strides()[trans_a ? 0 : 1];
+    size_t rs_b = b.strides()[trans_b ? 1 : 0];
+    size_t cs_b = b.strides()[trans_b ? 0 : 1];
+
+    gemm_strided(M, N, K, alpha,
+                 a.raw_data(), a.dtype(), rs_a, cs_a,
+                 b.raw_data(), b.dtype(), rs_b, cs_b,
+                 beta, c.data(), c.strides()[0]);
 }
 
-Tensor relu(const Tensor& a) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = std::max(0.0f, a[i]);
-    }
+Tensor bmm(const Tensor& a, const Tensor& b) {
+    BatchOperand op_a = batch_operand(a, false, "a");
+    BatchOperand op_b = batch_operand(b, false, "b");
+    Tensor result({std::max(op_a.batch, op_b.batch), op_a.rows, op_b.cols});
+    gemm_batched(false, false, 1.0f, a, b, 0.0f, result);
     return result;
 }
 
-Tensor sigmoid(const Tensor& a) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = 1.0f / (1.0f + std::exp(-a[i]));
+void gemm_batched(bool trans_a, bool trans_b, float alpha,
+                  const Tensor& a, const Tensor& b, float beta, Tensor& c) {
+    BatchOperand op_a = batch_operand(a, trans_a, "a");
+    BatchOperand op_b = batch_operand(b, trans_b, "b");
+    BatchOperand op_c = batch_operand(c, false, "c");
+    const size_t M = op_a.rows;
+    const size_t K = op_a.cols;
+    const size_t N = op_b.cols;
+    const size_t batch = std::max(op_a.batch, op_b.batch);
+    if (op_b.rows != K) {
+        throw std::invalid_argument("bmm: inner dimensions differ (" + std::to_string(K) +
+                                    " vs " + std::to_string(op_b.rows) + ")");
+    }
+    if ((op_a.batch != batch && op_a.batch != 1) || (op_b.batch != batch && op_b.batch != 1)) {
+        throw std::invalid_argument("bmm: batch sizes " + std::to_string(op_a.batch) + " and " +
+                                    std::to_string(op_b.batch) + " do not broadcast");
+    }
+    if (op_c.rows != M || op_c.cols != N || (op_c.batch != batch && op_c.batch != 1)) {
+        throw std::invalid_argument("bmm: output has the wrong shape");
+    }
+    if (c.dtype() != DType::Float32 || (N > 1 && op_c.cs != 1)) {
+        throw std::invalid_argument("bmm: output must be float32 with contiguous rows");
+    }
+
+    if (op_c.batch == batch) {
+        gemm_batched(batch, M, N, K, alpha,
+                     a.raw_data(), a.dtype(), op_a.bs, op_a.rs, op_a.cs,
+                     b.raw_data(), b.dtype(), op_b.bs, op_b.rs, op_b.cs,
+                     beta, c.data(), op_c.bs, op_c.rs);
+        return;
+    }
+
+    // Summing over the batch. When consecutive matrices of both operands
+    // continue each other along the inner dimension, the sum is one product
+    // with batch * K inner steps.
+    if (op_a.bs == K * op_a.cs && op_b.bs == K * op_b.rs && op_a.bs != 0 && op_b.bs != 0) {
+        gemm_strided(M, N, batch * K, alpha,
+                     a.raw_data(), a.dtype(), op_a.rs, op_a.cs,
+                     b.raw_data(), b.dtype(), op_b.rs, op_b.cs,
+                     beta, c.data(), op_c.rs);
+        return;
+    }
+    const size_t a_bytes = op_a.bs * a.element_size();
+    const size_t b_bytes = op_b.bs * b.element_size();
+    float* c_ptr = c.data();
+    for (size_t p = 0; p < batch; ++p) {
+        gemm_strided(M, N, K, alpha,
+                     static_cast<const char*>(a.raw_data()) + p * a_bytes, a.dtype(), op_a.rs, op_a.cs,
+                     static_cast<const char*>(b.raw_data()) + p * b_bytes, b.dtype(), op_b.rs, op_b.cs,
+                     p == 0 ? beta : 1.0f, c_ptr, op_c.rs);
     }
-    return result;
 }
 
-Tensor tanh(const Tensor& a) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = std::tanh(a[i]);
+PackedMatrix pack_gemm_rhs(const Tensor& b, bool trans_b) {
+    check_matrix(b, "pack_gemm_rhs", "b");
+    size_t K = trans_b ? b.shape()[1] : b.shape()[0];
+    size_t N = trans_b ? b.shape()[0] : b.shape()[1];
+    return PackedMatrix(K, N, b.raw_data(), b.dtype(),
+                        b.strides()[trans_b ? 1 : 0], b.strides()[trans_b ? 0 : 1]);
+}
+
+void gemm(bool trans_a, float alpha, const Tensor& a, const PackedMatrix& b, float beta, Tensor& c) {
+    check_matrix(a, "gemm", "a");
+    size_t M = trans_a ? a.shape()[1] : a.shape()[0];
+    size_t K = trans_a ? a.shape()[0] : a.shape()[1];
+    size_t N = b.cols();
+
+    check_inner(K, b.rows(), "gemm");
+    check_gemm_out(c, M, N, "gemm");
+
+    gemm_prepacked(M, N, K, alpha,
+                   a.raw_data(), a.dtype(), a.strides()[trans_a ? 1 : 0], a.strides()[trans_a ? 0 : 1],
+                   b, beta, c.data(), c.strides()[0]);
+}
+
+Tensor linear_row(const Tensor& x, const Tensor& w, const Tensor& bias, Activation act) {
+    check_matrix(x, "linear_row", "x");
+    check_matrix(w, "linear_row", "w");
+    if (x.shape()[0] != 1) {
+        throw std::invalid_argument("linear_row: x must be a single row");
+    }
+    check_inner(x.shape()[1], w.shape()[0], "linear_row");
+    const size_t K = w.shape()[0];
+    const size_t N = w.shape()[1];
+    if (bias.size() != 0 && bias.size() != N) {
+        throw std::invalid_argument("linear_row: bias must have one value per output column");
     }
+
+    // The kernel wants unit column stride; anything else is copied first.
+    Tensor wf = w;
+    if (w.dtype() != DType::Float32 || (N > 1 && w.strides()[1] != 1)) {
+        wf = w.to(DType::Float32).contiguous();
+    }
+    Tensor xf = x.to(DType::Float32).contiguous();
+    Tensor bf = bias.size() != 0 ? bias.to(DType::Float32).contiguous() : bias;
+
+    Tensor result({1, N});
+    const float* x_ptr = xf.data();
+    const float* w_ptr = wf.data();
+    const size_t ldw = wf.strides()[0];
+    const float* b_ptr = bf.size() != 0 ? bf.data() : nullptr;
+    float* y = result.data();
+    const kernels::GemvKernel gemv = kernels::table().sgemv;
+
+    const size_t blocks = (N + GEMV_COLS - 1) / GEMV_COLS;
+    const size_t grain = std::max<size_t>(1, GEMV_GRAIN / (GEMV_COLS * std::max<size_t>(K, 1)));
+    parallel_for(0, blocks, grain, [&](size_t begin, size_t end) {
+        for (size_t blk = begin; blk < end; ++blk) {
+            size_t j = blk * GEMV_COLS;
+            size_t n = std::min(GEMV_COLS, N - j);
+            if (b_ptr) {
+                std::copy(b_ptr + j, b_ptr + j + n, y + j);
+            } else {
+                std::fill(y + j, y + j + n, 0.0f);
+            }
+            gemv(K, n, x_ptr, w_ptr + j, ldw, y + j);
+            activate(y + j, n, act);
+        }
+    });
     return result;
 }
 
-Tensor exp(const Tensor& a) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = std::exp(a[i]);
+void apply_activation(Tensor& a, Activation act) {
+    if (!a.is_contiguous()) {
+        throw std::invalid_argument("apply_activation: a must be contiguous");
+    }
+    if (act != Activation::None) {
+        activate(a.data(), a.size(), act);
     }
-    return result;
+}
+
+Tensor transpose(const Tensor& a) {
+    return a.transpose(0, 1);
+}
+
+Tensor relu(const Tensor& a) {
+    return scalar_op(a, 0.0f, kernels::table().max_scalar);
+}
+
+Tensor sigmoid(const Tensor& a) {
+    return array_op(a, kernels::table().sigmoid);
+}
+
+Tensor tanh(const Tensor& a) {
+    return array_op(a, kernels::table().tanh);
+}
+
+void relu(const Tensor& a, Tensor& out) {
+    check_out(out, a.shape(), "relu");
+    scalar_into(a, 0.0f, out, kernels::table().max_scalar);
+}
+
+void sigmoid(const Tensor& a, Tensor& out) {
+    check_out(out, a.shape(), "sigmoid");
+    array_into(a, out, kernels::table().sigmoid);
+}
+
+void tanh(const Tensor& a, Tensor& out) {
+    check_out(out, a.shape(), "tanh");
+    array_into(a, out, kernels::table().tanh);
+}
+
+Tensor exp(const Tensor& a) {
+    return array_op(a, kernels::table().exp);
 }
 
 Tensor log(const Tensor& a) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = std::log(a[i] + 1e-8f);
+    if (a.dtype() != DType::Float32) {
+        // The 1e-8 offset would round away in 16 bits.
+        return log(a.to(DType::Float32)).to(a.dtype());
     }
+    Tensor result = add_scalar(a, 1e-8f);
+    float* r_ptr = result.data();
+    parallel_for(0, result.size(), TRANSCENDENTAL_GRAIN, [&](size_t begin, size_t end) {
+        kernels::table().log(r_ptr + begin, r_ptr + begin, end - begin);
+    });
     return result;
 }
 
 Tensor max(const Tensor& a, const Tensor& b) {
-    Tensor result(a.shape());
-    for (size_t i = 0; i < a.size(); ++i) {
-        result[i] = std::max(a[i], b[i]);
-    }
-    return result;
+    return binary_op(a, b, kernels::table().max);
 }
 
 } // namespace ops
@@ -0,0 +1,63 @@
+#include "core/kernels.hpp"
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <cstring>
+#include <immintrin.h>
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+static_assert(QGEMM_MR == 4 && QGEMM_NR == 16, "AVX2 int8 microkernel is written for a 4x16 tile");
+
+namespace {
+
+// vpmaddwd multiplies the (even k, odd k) int16 pair broadcast from a row of a
+// with the pair of each column of b and adds the two products, so one
+// instruction does two steps of k for eight columns.
+template <int ROWS>
+void qgemm_tile(size_t kpairs, const int16_t* a, size_t lda, const int8_t* b, int32_t* c, size_t ldc) {
+    __m256i acc[ROWS][2];
+    for (int r = 0; r < ROWS; ++r) {
+        acc[r][0] = _mm256_setzero_si256();
+        acc[r][1] = _mm256_setzero_si256();
+    }
+
+    for (size_t t = 0; t < kpairs; ++t) {
+        __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+        __m256i b1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16)));
+        b += 2 * QGEMM_NR;
+
+        for (int r = 0; r < ROWS; ++r) {
+            int32_t pair;
+            std::memcpy(&pair, a + r * lda + 2 * t, sizeof(pair));
+            __m256i av = _mm256_set1_epi32(pair);
+            acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_madd_epi16(av, b0));
+            acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_madd_epi16(av, b1));
+        }
+    }
+
+    for (int r = 0; r < ROWS; ++r) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + r * ldc), acc[r][0]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + r * ldc + 8), acc[r][1]);
+    }
+}
+
+} // namespace
+
+void qgemm_ukernel_avx2(size_t mr, size_t kpairs, const int16_t* a, size_t lda,
+                        const int8_t* b, int32_t* c, size_t ldc) {
+    switch (mr) {
+        case 4: qgemm_tile<4>(kpairs, a, lda, b, c, ldc); break;
+        case 3: qgemm_tile<3>(kpairs, a, lda, b, c, ldc); break;
+        case 2: qgemm_tile<2>(kpairs, a, lda, b, c, ldc); break;
+        case 1: qgemm_tile<1>(kpairs, a, lda, b, c, ldc); break;
+        default: break;
+    }
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
+
+#endif
@@ -0,0 +1,55 @@
+#include "core/kernels.hpp"
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#include <cstring>
+#include <immintrin.h>
+
+namespace mtf {
+namespace core {
+namespace kernels {
+
+static_assert(QGEMM_MR == 4 && QGEMM_NR == 16, "AVX-512 int8 microkernel is written for a 4x16 tile");
+
+namespace {
+
+// Same pair layout as the AVX2 kernel, but one 32-byte step of b widens to a
+// full zmm, so a single vpmaddwd covers all 16 columns of a row.
+template <int ROWS>
+void qgemm_tile(size_t kpairs, const int16_t* a, size_t lda, const int8_t* b, int32_t* c, size_t ldc) {
+    __m512i acc[ROWS];
+    for (int r = 0; r < ROWS; ++r) acc[r] = _mm512_setzero_si512();
+
+    for (size_t t = 0; t < kpairs; ++t) {
+        __m512i bv = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)));
+        b += 2 * QGEMM_NR;
+
+        for (int r = 0; r < ROWS; ++r) {
+            int32_t pair;
+            std::memcpy(&pair, a + r * lda + 2 * t, sizeof(pair));
+            acc[r] = _mm512_add_epi32(acc[r], _mm512_madd_epi16(_mm512_set1_epi32(pair), bv));
+        }
+    }
+
+    for (int r = 0; r < ROWS; ++r) {
+        _mm512_storeu_si512(c + r * ldc, acc[r]);
+    }
+}
+
+} // namespace
+
+void qgemm_ukernel_avx512(size_t mr, size_t kpairs, const int16_t* a, size_t lda,
+                          const int8_t* b, int32_t* c, size_t ldc) {
+    switch (mr) {
+        case 4: qgemm_tile<4>(kpairs, a, lda, b, c, ldc); break;
+        case 3: qgemm_tile<3>(kpairs, a, lda, b, c, ldc); break;
+        case 2: qgemm_tile<2>(kpairs, a, lda, b, c, ldc); break;
+        case 1: qgemm_tile<1>(kpairs, a, lda, b, c, ldc); break;
+        default: break;
+    }
+}
+
+} // namespace kernels
+} // namespace core
+} // namespace mtf
+
+#endif
@@ -0,0 +1,204 @@
+#include "core/quant.hpp"
+#include "core/kernels.hpp"
+#include "core/thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace mtf {
+namespace core {
+namespace quant {
+
+namespace {
+
+constexpr size_t MR = kernels::QGEMM_MR;
+constexpr size_t NR = kernels::QGEMM_NR;
+
+// |q| <= 127, so K products of two of them fit int32 up to this many rows.
+constexpr size_t MAX_ROWS = 2147483647 / (127 * 127);
+
+// Multiply-adds per task before threading pays off.
+constexpr size_t QGEMM_GRAIN = 1 << 18;
+constexpr size_t QUANTIZE_GRAIN = 32768;
+
+// Rounds to nearest even: adding 1.5 * 2^23 leaves no fraction bits. Unlike
+// lrint this vectorizes, as long as the clamp comes after the rounding. NaN
+// would pass through the clamp and make the cast undefined, so it becomes 0.
+inline int32_t quantize(float x, float inv_scale) {
+    const float round_magic = 12582912.0f;
+    float v = (x * inv_scale + round_magic) - round_magic;
+    v = v == v ? v : 0.0f;
+    v = std::min(std::max(v, -127.0f), 127.0f);
+    return static_cast<int32_t>(v);
+}
+
+void quantize_row(const float* x, size_t n, float inv_scale, int16_t* q) {
+    for (size_t i = 0; i < n; ++i) {
+        q[i] = static_cast<int16_t>(quantize(x[i], inv_scale));
+    }
+}
+
+// Interleaved partial maxima let the compiler vectorize the reduction.
+constexpr size_t ABSMAX_LANES = 16;
+
+} // namespace
+
+float absmax_scale(const float* x, size_t n) {
+    float lanes[ABSMAX_LANES] = {};
+    size_t i = 0;
+    for (; i + ABSMAX_LANES <= n; i += ABSMAX_LANES) {
+        for (size_t j = 0; j < ABSMAX_LANES; ++j) {
+            float a = std::fabs(x[i + j]);
+            lanes[j] = lanes[j] < a ? a : lanes[j];
+        }
+    }
+    float m = 0.0f;
+    for (; i < n; ++i) m = std::max(m, std::fabs(x[i]));
+    for (size_t j = 0; j < ABSMAX_LANES; ++j) m = std::max(m, lanes[j]);
+    return m > 0.0f ? m / 127.0f : 1.0f;
+}
+
+Int8Weights::Int8Weights(const Tensor& weight) {
+    if (weight.shape().size() != 2) {
+        throw std::invalid_argument("Int8Weights: weight must be [K, N]");
+    }
+    rows_ = weight.shape()[0];
+    cols_ = weight.shape()[1];
+    if (rows_ > MAX_ROWS) {
+        throw std::invalid_argument("Int8Weights: too many rows for int32 accumulation");
+    }
+    kpairs_ = (rows_ + 1) / 2;
+    panel_size_ = kpairs_ * 2 * NR;
+
+    Tensor w = weight.to(DType::Float32).contiguous();
+    const float* src = w.data();
+
+    scales_.assign(cols_, 0.0f);
+    for (size_t k = 0; k < rows_; ++k) {
+        for (size_t j = 0; j < cols_; ++j) {
+            scales_[j] = std::max(scales_[j], std::fabs(src[k * cols_ + j]));
+        }
+    }
+    for (float& s : scales_) {
+        s = s > 0.0f ? s / 127.0f : 1.0f;
+    }
+
+    size_t panels = (cols_ + NR - 1) / NR;
+    packed_.assign(panels * panel_size_, 0);
+    for (size_t p = 0; p < panels; ++p) {
+        int8_t* out = packed_.data() + p * panel_size_;
+        size_t j0 = p * NR;
+        size_t width = std::min(NR, cols_ - j0);
+        for (size_t k = 0; k < rows_; ++k) {
+            int8_t* pair = out + (k / 2) * 2 * NR + (k % 2);
+            for (size_t c = 0; c < width; ++c) {
+                pair[2 * c] = static_cast<int8_t>(quantize(src[k * cols_ + j0 + c], 1.0f / scales_[j0 + c]));
+            }
+        }
+    }
+}
+
+Tensor Int8Weights::dequantize() const {
+    Tensor w({rows_, cols_});
+    float* dst = w.data();
+    for (size_t k = 0; k < rows_; ++k) {
+        for (size_t j = 0; j < cols_; ++j) {
+            const int8_t* pair = panel(j / NR) + (k / 2) * 2 * NR + (k % 2);
+            dst[k * cols_ + j] = scales_[j] * pair[2 * (j % NR)];
+        }
+    }
+    return w;
+}
+
+Tensor linear(const Tensor& x, const Int8Weights& w, const Tensor& bias, float x_scale, bool relu) {
+    Tensor result({x.shape().size() == 2 ? x.shape()[0] : 0, w.cols()});
+    linear(x, w, bias, result, x_scale, relu);
+    return result;
+}
+
+void linear(const Tensor& x, const Int8Weights& w, const Tensor& bias, Tensor& out,
+            float x_scale, bool relu) {
+    if (x.shape().size() != 2 || x.shape()[1] != w.rows()) {
+        throw std::invalid_argument("quant::linear: input must be [M, K] with K = weight rows");
+    }
+    if (bias.size() != 0 && bias.size() != w.cols()) {
+        throw std::invalid_argument("quant::linear: bias must have one value per output column");
+    }
+
+    const size_t M = x.shape()[0];
+    const size_t K = w.rows();
+    const size_t N = w.cols();
+    const size_t kpairs = w.kpairs();
+    const size_t lda = 2 * kpairs;
+
+    if (out.shape() != Tensor::Shape{M, N} || !out.is_contiguous() || out.dtype() != DType::Float32) {
+        throw std::invalid_argument("quant::linear: out must be contiguous float32 [M, N]");
+    }
+    if (M == 0 || N == 0) return;
+
+    Tensor src;
+    const bool convert_x = x.dtype() != DType::Float32 || !x.is_contiguous();
+    if (convert_x) src = x.to(DType::Float32).contiguous();
+    Tensor b;
+    const bool convert_b = bias.size() != 0 && (bias.dtype() != DType::Float32 || !bias.is_contiguous());
+    if (convert_b) b = bias.to(DType::Float32).contiguous();
+
+    // Activations as int16 rows padded to an even length, for the pair layout.
+    // The buffers are kept per thread, so repeated calls do not allocate.
+    thread_local std::vector<int16_t> qa_buffer;
+    thread_local std::vector<float> scale_buffer;
+    std::vector<int16_t>& qa = qa_buffer;
+    std::vector<float>& row_scale = scale_buffer;
+    if (qa.size() < M * lda) qa.resize(M * lda);
+    if (row_scale.size() < M) row_scale.resize(M);
+    if (lda != K) {
+        for (size_t i = 0; i < M; ++i) qa[i * lda + K] = 0;
+    }
+    const float* x_ptr = (convert_x ? static_cast<const Tensor&>(src) : x).data();
+    parallel_for(0, M, std::max<size_t>(1, QUANTIZE_GRAIN / std::max<size_t>(K, 1)), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const float* row = x_ptr + i * K;
+            float s = x_scale > 0.0f ? x_scale : absmax_scale(row, K);
+            quantize_row(row, K, 1.0f / s, qa.data() + i * lda);
+            row_scale[i] = s;
+        }
+    });
+
+    const kernels::QGemmMicroKernel ukernel = kernels::table().qgemm_ukernel;
+    const float* w_scale = w.scales().data();
+    const float* b_ptr = bias.size() == 0 ? nullptr
+                       : (convert_b ? static_cast<const Tensor&>(b) : bias).data();
+    float* y = out.data();
+
+    // Tasks walk down the row blocks of one weight panel before the next, so
+    // the panel stays in cache.
+    const size_t row_blocks = (M + MR - 1) / MR;
+    const size_t panels = (N + NR - 1) / NR;
+    const size_t grain = std::max<size_t>(1, QGEMM_GRAIN / (MR * NR * std::max<size_t>(K, 1)));
+    parallel_for(0, row_blocks * panels, grain, [&](size_t begin, size_t end) {
+        alignas(32) int32_t acc[MR * NR];
+        for (size_t t = begin; t < end; ++t) {
+            size_t i0 = (t % row_blocks) * MR;
+            size_t j0 = (t / row_blocks) * NR;
+            size_t mr = std::min(MR, M - i0);
+            size_t nr = std::min(NR, N - j0);
+
+            ukernel(mr, kpairs, qa.data() + i0 * lda, lda, w.panel(j0 / NR), acc, NR);
+
+            for (size_t r = 0; r < mr; ++r) {
+                const float sa = row_scale[i0 + r];
+                const int32_t* a_row = acc + r * NR;
+                float* out = y + (i0 + r) * N + j0;
+                for (size_t j = 0; j < nr; ++j) {
+                    float v = static_cast<float>(a_row[j]) * (sa * w_scale[j0 + j]);
+                    if (b_ptr) v += b_ptr[j0 + j];
+                    out[j] = relu ? std::max(v, 0.0f) : v;
+                }
+            }
+        }
+    });
+}
+
+} // namespace quant
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,98 @@
+#include "core/random.hpp"
+#include "core/kernels.hpp"
+#include "core/thread_pool.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace mtf {
+namespace core {
+
+namespace {
+
+// Counters per inner batch; the batch's words live on the stack.
+constexpr size_t CHUNK_BLOCKS = 64;
+// Counters per parallel task.
+constexpr size_t GRAIN_BLOCKS = size_t(1) << 12;
+
+// Top 24 bits as a float in [0, 1).
+inline float to_unit(uint32_t x) { return static_cast<float>(x >> 8) * (1.0f / 16777216.0f); }
+
+// Runs fn(first_counter, blocks, out) over [0, n) in chunks of CHUNK_BLOCKS
+// counters, spread over the pool. out receives 4 * blocks values, of which
+// only those below n are kept.
+template <typename Fn>
+void fill_parallel(float* dst, size_t n, uint64_t offset, Fn fn) {
+    const size_t total_blocks = (n + 3) / 4;
+    parallel_for(0, total_blocks, GRAIN_BLOCKS, [&](size_t begin, size_t end) {
+        float out[4 * CHUNK_BLOCKS];
+        for (size_t b = begin; b < end; b += CHUNK_BLOCKS) {
+            size_t blocks = std::min(CHUNK_BLOCKS, end - b);
+            fn(offset + b, blocks, out);
+            size_t count = std::min(4 * blocks, n - 4 * b);
+            std::memcpy(dst + 4 * b, out, count * sizeof(float));
+        }
+    });
+}
+
+uint64_t initial_seed() {
+    if (const char* env = std::getenv("MTF_SEED")) {
+        if (*env) return std::strtoull(env, nullptr, 10);
+    }
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) | rd();
+}
+
+} // namespace
+
+Generator::Generator(uint64_t seed) : seed_(seed), offset_(0) {}
+
+void Generator::manual_seed(uint64_t seed) {
+    seed_.store(seed, std::memory_order_relaxed);
+    offset_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Generator::reserve(size_t n) {
+    return offset_.fetch_add((n + 3) / 4, std::memory_order_relaxed);
+}
+
+void Generator::normal(float* dst, size_t n, float mean, float std) {
+    const uint64_t seed = this->seed();
+    const uint32_t k0 = static_cast<uint32_t>(seed);
+    const uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+    fill_parallel(dst, n, reserve(n), [&](uint64_t first, size_t blocks, float* out) {
+        const kernels::KernelTable& k = kernels::table();
+        uint32_t words[4 * CHUNK_BLOCKS];
+        float u1[2 * CHUNK_BLOCKS];
+        k.philox(first, blocks, k0, k1, words);
+        for (size_t p = 0; p < 2 * blocks; ++p) u1[p] = to_unit(words[2 * p]) + (1.0f / 16777216.0f);
+        k.log(u1, u1, 2 * blocks);
+        k.box_muller(words, u1, 2 * blocks, out);
+        for (size_t i = 0; i < 4 * blocks; ++i) out[i] = mean + std * out[i];
+    });
+}
+
+void Generator::uniform(float* dst, size_t n, float low, float high) {
+    const uint64_t seed = this->seed();
+    const uint32_t k0 = static_cast<uint32_t>(seed);
+    const uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+    const float scale = high - low;
+    fill_parallel(dst, n, reserve(n), [&](uint64_t first, size_t blocks, float* out) {
+        uint32_t words[4 * CHUNK_BLOCKS];
+        kernels::table().philox(first, blocks, k0, k1, words);
+        for (size_t i = 0; i < 4 * blocks; ++i) out[i] = low + scale * to_unit(words[i]);
+    });
+}
+
+Generator& default_generator() {
+    static Generator generator(initial_seed());
+    return generator;
+}
+
+void manual_seed(uint64_t seed) {
+    default_generator().manual_seed(seed);
+}
+
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,386 @@
+#include "core/ops_cpu.hpp"
+#include "core/kernels.hpp"
+#include "core/thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace mtf {
+namespace core {
+namespace ops {
+
+namespace {
+
+// Elements read per task before threading pays off.
+constexpr size_t REDUCTION_GRAIN = 32768;
+// Rows longer than this are reduced in blocks of this size, in parallel. The
+// blocking is fixed so results do not depend on the thread count.
+constexpr size_t REDUCTION_BLOCK = 16384;
+// Columns per task when reducing over an axis that is not innermost.
+constexpr size_t COLUMN_BLOCK = 256;
+// Rows added one after another before column sums switch to pairwise halving.
+constexpr size_t PAIRWISE_ROWS = 8;
+
+enum class ReduceOp { Sum, Max };
+
+std::vector<bool> reduced_axes(const Tensor::Shape& shape, const std::vector<int>& axes) {
+    const int ndim = static_cast<int>(shape.size());
+    std::vector<bool> reduced(shape.size(), axes.empty());
+    for (int axis : axes) {
+        int a = axis < 0 ? axis + ndim : axis;
+        if (a < 0 || a >= ndim) {
+            throw std::out_of_range("reduction axis " + std::to_string(axis) +
+                                    " is out of range for a tensor of rank " + std::to_string(ndim));
+        }
+        if (reduced[a]) {
+            throw std::invalid_argument("reduction axis " + std::to_string(axis) + " is repeated");
+        }
+        reduced[a] = true;
+    }
+    return reduced;
+}
+
+Tensor::Shape reduced_shape(const Tensor::Shape& shape, const std::vector<bool>& reduced, bool keepdim) {
+    Tensor::Shape out;
+    for (size_t d = 0; d < shape.size(); ++d) {
+        if (!reduced[d]) {
+            out.push_back(shape[d]);
+        } else if (keepdim) {
+            out.push_back(1);
+        }
+    }
+    if (out.empty()) {
+        out.push_back(1);
+    }
+    return out;
+}
+
+// Runs of neighbouring dimensions that are all reduced or all kept, with size-1
+// dimensions dropped. Consecutive groups alternate between the two kinds.
+struct Group {
+    size_t size;
+    bool reduced;
+};
+
+std::vector<Group> make_groups(const Tensor::Shape& shape, const std::vector<bool>& reduced) {
+    std::vector<Group> groups;
+    for (size_t d = 0; d < shape.size(); ++d) {
+        if (shape[d] == 1) continue;
+        if (!groups.empty() && groups.back().reduced == reduced[d]) {
+            groups.back().size *= shape[d];
+        } else {
+            groups.push_back({shape[d], reduced[d]});
+        }
+    }
+    return groups;
+}
+
+inline float max_nan(float acc, float x) {
+    return (x > acc || x != x) ? x : acc;
+}
+
+// out[o] = reduce(x[o, 0..R)) for o < O.
+void reduce_rows(const float* x, size_t O, size_t R, float* out, kernels::ReduceKernel kernel) {
+    if (R <= REDUCTION_BLOCK) {
+        size_t grain = std::max<size_t>(1, REDUCTION_GRAIN / R);
+        parallel_for(0, O, grain, [&](size_t begin, size_t end) {
+            for (size_t o = begin; o < end; ++o) {
+                out[o] = kernel(x + o * R, R);
+            }
+        });
+        return;
+    }
+
+    size_t blocks = (R + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK;
+    thread_local std::vector<float> partial_buffer;
+    std::vector<float>& partial = partial_buffer;
+    if (partial.size() < O * blocks) partial.resize(O * blocks);
+    parallel_for(0, O * blocks, 1, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            size_t first = (t % blocks) * REDUCTION_BLOCK;
+            size_t count = std::min(REDUCTION_BLOCK, R - first);
+            partial[t] = kernel(x + (t / blocks) * R + first, count);
+        }
+    });
+    for (size_t o = 0; o < O; ++o) {
+        out[o] = kernel(partial.data() + o * blocks, blocks);
+    }
+}
+
+size_t pairwise_depth(size_t rows) {
+    size_t depth = 1;
+    while (rows > PAIRWISE_ROWS) {
+        rows = (rows + 1) / 2;
+        ++depth;
+    }
+    return depth;
+}
+
+// out[0..width) = sum of `rows` rows of x spaced `stride` apart, added pairwise.
+// scratch holds width * pairwise_depth(rows) floats.
+void column_sum(const float* x, size_t rows, size_t width, size_t stride,
+                float* out, float* scratch) {
+    const kernels::BinaryKernel add = kernels::table().add;
+    if (rows <= PAIRWISE_ROWS) {
+        std::memcpy(out, x, width * sizeof(float));
+        for (size_t r = 1; r < rows; ++r) {
+            add(out, 1, x + r * stride, 1, out, width);
+        }
+        return;
+    }
+    size_t half = rows / 2;
+    column_sum(x, half, width, stride, out, scratch + width);
+    column_sum(x + half * stride, rows - half, width, stride, scratch, scratch + width);
+    add(out, 1, scratch, 1, out, width);
+}
+
+void column_max(const float* x, size_t rows, size_t width, size_t stride, float* out) {
+    std::memcpy(out, x, width * sizeof(float));
+    for (size_t r = 1; r < rows; ++r) {
+        const float* row = x + r * stride;
+        for (size_t i = 0; i < width; ++i) out[i] = max_nan(out[i], row[i]);
+    }
+}
+
+// Calls fn(o, c0, width) over blocks of columns of an [O, R, I] reduction.
+template <typename Fn>
+void for_each_column_block(size_t O, size_t R, size_t I, Fn fn) {
+    size_t chunks = (I + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+    size_t grain = std::max<size_t>(1, REDUCTION_GRAIN / (R * std::min(I, COLUMN_BLOCK)));
+    parallel_for(0, O * chunks, grain, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            size_t c0 = (t % chunks) * COLUMN_BLOCK;
+            fn(t / chunks, c0, std::min(COLUMN_BLOCK, I - c0));
+        }
+    });
+}
+
+// Reduces the middle dimension of a contiguous [O, R, I] array into [O, I].
+void reduce_ori(const float* x, size_t O, size_t R, size_t I, float* out, ReduceOp op) {
+    if (I == 1) {
+        const kernels::KernelTable& k = kernels::table();
+        reduce_rows(x, O, R, out, op == ReduceOp::Sum ? k.sum : k.max_reduce);
+        return;
+    }
+
+    if (op == ReduceOp::Sum) {
+        const size_t depth = pairwise_depth(R);
+        for_each_column_block(O, R, I, [&](size_t o, size_t c0, size_t width) {
+            // Per thread that runs the block, grown once to the deepest sum seen.
+            thread_local std::vector<float> scratch;
+            if (scratch.size() < COLUMN_BLOCK * depth) scratch.resize(COLUMN_BLOCK * depth);
+            column_sum(x + o * R * I + c0, R, width, I, out + o * I + c0, scratch.data());
+        });
+    } else {
+        for_each_column_block(O, R, I, [&](size_t o, size_t c0, size_t width) {
+            column_max(x + o * R * I + c0, R, width, I, out + o * I + c0);
+        });
+    }
+}
+
+// Reduces a over the `reduced` axes into dst, which holds the `count` kept
+// elements. Runs of reduced dimensions are reduced one at a time, innermost
+// first; every run but the last goes through per-thread scratch, so a
+// contiguous float32 input reduced over one run allocates nothing.
+void reduce_into(const Tensor& a, const std::vector<bool>& reduced, ReduceOp op,
+                 float* dst, size_t count) {
+    if (a.size() == 0) {
+        if (count > 0 && op == ReduceOp::Max) {
+            throw std::invalid_argument("max over an empty dimension");
+        }
+        std::fill(dst, dst + count, 0.0f);
+        return;
+    }
+
+    Tensor converted;
+    const bool convert = a.dtype() != DType::Float32 || !a.is_contiguous();
+    if (convert) {
+        converted = a.to(DType::Float32).contiguous();
+    }
+    const float* data = (convert ? static_cast<const Tensor&>(converted) : a).data();
+
+    std::vector<Group> groups = make_groups(a.shape(), reduced);
+    size_t runs = 0;
+    for (const Group& group : groups) runs += group.reduced ? 1 : 0;
+    if (runs == 0) {
+        std::memcpy(dst, data, count * sizeof(float));
+        return;
+    }
+
+    thread_local std::vector<float> scratch[2];
+    for (size_t g = groups.size(); g-- > 0;) {
+        if (!groups[g].reduced) continue;
+
+        size_t outer = 1;
+        size_t inner = 1;
+        for (size_t i = 0; i < g; ++i) outer *= groups[i].size;
+        for (size_t i = g + 1; i < groups.size(); ++i) inner *= groups[i].size;
+
+        float* out = dst;
+        if (--runs > 0) {
+            std::vector<float>& buffer = scratch[runs % 2];
+            if (buffer.size() < outer * inner) buffer.resize(outer * inner);
+            out = buffer.data();
+        }
+        reduce_ori(data, outer, groups[g].size, inner, out, op);
+        data = out;
+
+        groups.erase(groups.begin() + g);
+        if (g > 0 && g < groups.size()) {
+            groups[g - 1].size *= groups[g].size;
+            groups.erase(groups.begin() + g);
+        }
+    }
+}
+
+Tensor reduce(const Tensor& a, const std::vector<int>& axes, bool keepdim, ReduceOp op) {
+    std::vector<bool> reduced = reduced_axes(a.shape(), axes);
+    Tensor result(reduced_shape(a.shape(), reduced, keepdim));
+    reduce_into(a, reduced, op, result.data(), result.size());
+    return result;
+}
+
+// Throws unless out is contiguous float32 with the given shape.
+void check_out(const Tensor& out, const Tensor::Shape& shape, const char* op) {
+    if (out.shape() != shape) {
+        throw std::invalid_argument(std::string(op) + ": out does not have the result shape");
+    }
+    if (!out.is_contiguous() || out.dtype() != DType::Float32) {
+        throw std::invalid_argument(std::string(op) + ": out must be contiguous float32");
+    }
+}
+
+void scale_mean(const Tensor& a, Tensor& result) {
+    if (result.size() == 0) {
+        return;
+    }
+    if (a.size() == 0) {
+        throw std::invalid_argument("mean over an empty dimension");
+    }
+    size_t count = a.size() / result.size();
+    float scale = 1.0f / static_cast<float>(count);
+    float* r = result.data();
+    for (size_t i = 0; i < result.size(); ++i) {
+        r[i] *= scale;
+    }
+}
+
+} // namespace
+
+Tensor sum(const Tensor& a) {
+    return reduce(a, {}, false, ReduceOp::Sum);
+}
+
+Tensor mean(const Tensor& a) {
+    return mean(a, {}, false);
+}
+
+Tensor sum(const Tensor& a, const std::vector<int>& axes, bool keepdim) {
+    return reduce(a, axes, keepdim, ReduceOp::Sum);
+}
+
+Tensor mean(const Tensor& a, const std::vector<int>& axes, bool keepdim) {
+    Tensor result = reduce(a, axes, keepdim, ReduceOp::Sum);
+    scale_mean(a, result);
+    return result;
+}
+
+void sum(const Tensor& a, const std::vector<int>& axes, bool keepdim, Tensor& out) {
+    std::vector<bool> reduced = reduced_axes(a.shape(), axes);
+    check_out(out, reduced_shape(a.shape(), reduced, keepdim), "sum");
+    reduce_into(a, reduced, ReduceOp::Sum, out.data(), out.size());
+}
+
+void mean(const Tensor& a, const std::vector<int>& axes, bool keepdim, Tensor& out) {
+    sum(a, axes, keepdim, out);
+    scale_mean(a, out);
+}
+
+Tensor max(const Tensor& a, const std::vector<int>& axes, bool keepdim) {
+    return reduce(a, axes, keepdim, ReduceOp::Max);
+}
+
+Tensor argmax(const Tensor& a, int axis, bool keepdim) {
+    const Tensor::Shape& shape = a.shape();
+    std::vector<bool> reduced = reduced_axes(shape, {axis});
+    Tensor result(reduced_shape(shape, reduced, keepdim));
+
+    size_t d = static_cast<size_t>(std::find(reduced.begin(), reduced.end(), true) - reduced.begin());
+    size_t O = 1;
+    size_t I = 1;
+    for (size_t i = 0; i < d; ++i) O *= shape[i];
+    for (size_t i = d + 1; i < shape.size(); ++i) I *= shape[i];
+    const size_t R = shape[d];
+
+    if (result.size() == 0) return result;
+    if (R == 0) {
+        throw std::invalid_argument("argmax over an empty dimension");
+    }
+
+    Tensor src = a.to(DType::Float32).contiguous();
+    const float* x = src.data();
+    float* out = result.data();
+
+    if (I == 1) {
+        const kernels::ReduceKernel max_reduce = kernels::table().max_reduce;
+        size_t grain = std::max<size_t>(1, REDUCTION_GRAIN / R);
+        parallel_for(0, O, grain, [&](size_t begin, size_t end) {
+            for (size_t o = begin; o < end; ++o) {
+                const float* row = x + o * R;
+                float m = max_reduce(row, R);
+                size_t idx = 0;
+                while (idx < R && !(row[idx] == m || (m != m && row[idx] != row[idx]))) ++idx;
+                out[o] = static_cast<float>(idx);
+            }
+        });
+        return result;
+    }
+
+    for_each_column_block(O, R, I, [&](size_t o, size_t c0, size_t width) {
+        const float* base = x + o * R * I + c0;
+        float* idx = out + o * I + c0;
+        float best[COLUMN_BLOCK];
+        std::copy(base, base + width, best);
+        std::fill(idx, idx + width, 0.0f);
+        for (size_t r = 1; r < R; ++r) {
+            const float* row = base + r * I;
+            const float rf = static_cast<float>(r);
+            for (size_t i = 0; i < width; ++i) {
+                bool better = row[i] > best[i] || (row[i] != row[i] && best[i] == best[i]);
+                best[i] = better ? row[i] : best[i];
+                idx[i] = better ? rf : idx[i];
+            }
+        }
+    });
+    return result;
+}
+
+Tensor reduce_to_shape(const Tensor& grad, const Tensor::Shape& shape) {
+    Tensor result(shape);
+    reduce_to_shape(grad, shape, result);
+    return result;
+}
+
+void reduce_to_shape(const Tensor& grad, const Tensor::Shape& shape, Tensor& out) {
+    const Tensor::Shape& g_shape = grad.shape();
+    if (g_shape.size() < shape.size()) {
+        throw std::invalid_argument("reduce_to_shape: the target has more dimensions than the gradient");
+    }
+    check_out(out, shape, "reduce_to_shape");
+
+    size_t lead = g_shape.size() - shape.size();
+    std::vector<bool> reduced(g_shape.size());
+    for (size_t d = 0; d < g_shape.size(); ++d) {
+        reduced[d] = d < lead || (shape[d - lead] == 1 && g_shape[d] != 1);
+        if (!reduced[d] && d >= lead && shape[d - lead] != g_shape[d]) {
+            throw std::invalid_argument("reduce_to_shape: the gradient does not broadcast from the target");
+        }
+    }
+    reduce_into(grad, reduced, ReduceOp::Sum, out.data(), out.size());
+}
+
+} // namespace ops
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,33 @@
+#include "core/storage.hpp"
+#include "core/arena.hpp"
+#include "core/memory.hpp"
+
+namespace mtf {
+namespace core {
+
+Storage::Storage(size_t nbytes)
+    : data_(nullptr), nbytes_(nbytes), in_arena_(StepArena::active()) {
+    if (nbytes_ > 0) {
+        data_ = in_arena_ ? StepArena::allocate(nbytes_) : aligned_alloc(nbytes_);
+    }
+}
+
+Storage::~Storage() {
+    if (data_) {
+        if (in_arena_) {
+            StepArena::deallocate(data_);
+        } else {
+            aligned_free(data_);
+        }
+    }
+}
+
+std::shared_ptr<Storage> Storage::create(size_t nbytes) {
+    if (StepArena::active()) {
+        return std::allocate_shared<Storage>(ArenaAllocator<Storage>(), nbytes);
+    }
+    return std::make_shared<Storage>(nbytes);
+}
+
+} // namespace core
+} // namespace mtf
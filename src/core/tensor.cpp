@@ -1,24 +1,84 @@
 #include "core/tensor.hpp"
-#include "core/memory.hpp"
+#include "core/broadcast.hpp"
+#include "core/kernels.hpp"
+#include "core/random.hpp"
+#include "core/thread_pool.hpp"
 #include <numeric>
 #include <algorithm>
-#include <random>
 #include <iostream>
 #include <cstring>
 #include <fstream>
+#include <stdexcept>
 
 namespace mtf {
 namespace core {
 
-Tensor::Tensor() : data_(nullptr), size_(0), shape_({}), strides_({}), owns_memory_(false) {}
+namespace {
 
-Tensor::Tensor(const Shape& shape) : shape_(shape), owns_memory_(true) {
+// Elements converted per task by Tensor::to.
+constexpr size_t CONVERT_GRAIN = 32768;
+
+// Files written by save() start with FILE_MAGIC, the format version and the
+// dtype, followed by the rank, the shape, the element count and the raw
+// elements. Older files have no header and hold float32 data; they start with
+// the rank, which can never read as FILE_MAGIC.
+const char FILE_MAGIC[4] = {'M', 'T', 'F', 'T'};
+constexpr uint32_t FILE_VERSION = 2;
+
+// dst[i] = src[i] over `shape`, both strided, for elements of type T.
+template <typename T>
+void copy_elements(const Tensor::Shape& shape, size_t size,
+                   T* dst, const Tensor::Strides& dst_strides,
+                   const T* src, const Tensor::Strides& src_strides) {
+    BroadcastLoop loop(shape, {dst_strides, src_strides});
+    const size_t ds = loop.inner_stride(0);
+    const size_t ss = loop.inner_stride(1);
+    loop.for_each_run(0, size, [&](const size_t* off, size_t count) {
+        T* d = dst + off[0];
+        const T* s = src + off[1];
+        for (size_t j = 0; j < count; ++j) d[j * ds] = s[j * ss];
+    });
+}
+
+template <typename T>
+void fill_elements(const Tensor::Shape& shape, size_t size, T* dst,
+                   const Tensor::Strides& strides, T value) {
+    BroadcastLoop loop(shape, {strides});
+    const size_t ds = loop.inner_stride(0);
+    loop.for_each_run(0, size, [&](const size_t* off, size_t count) {
+        T* d = dst + off[0];
+        for (size_t j = 0; j < count; ++j) d[j * ds] = value;
+    });
+}
+
+kernels::NarrowKernel narrow_kernel(DType dtype) {
+    const kernels::KernelTable& k = kernels::table();
+    return dtype == DType::BFloat16 ? k.float_to_bf16 : k.float_to_fp16;
+}
+
+kernels::WidenKernel widen_kernel(DType dtype) {
+    const kernels::KernelTable& k = kernels::table();
+    return dtype == DType::BFloat16 ? k.bf16_to_float : k.fp16_to_float;
+}
+
+bool valid_dtype(uint32_t value) {
+    return value <= static_cast<uint32_t>(DType::Float16);
+}
+
+} // namespace
+
+Tensor::Tensor() : data_(nullptr), dtype_(DType::Float32), size_(0), shape_({}), strides_({}), owns_memory_(false) {}
+
+Tensor::Tensor(const Shape& shape) : Tensor(shape, DType::Float32) {}
+
+Tensor::Tensor(const Shape& shape, DType dtype) : dtype_(dtype), shape_(shape), owns_memory_(true) {
     size_ = 1;
     for (auto dim : shape) {
         size_ *= dim;
     }
     strides_ = compute_strides(shape);
-    data_ = static_cast<float*>(aligned_alloc(size_ * sizeof(float)));
+    storage_ = Storage::create(size_ * dtype_size(dtype));
+    data_ = storage_->data();
 }
 
 Tensor::Tensor(const Shape& shape, const std::vector<float>& data) : Tensor(shape) {
@@ -34,55 +94,37 @@ Tensor::Tensor(std::initializer_list<float> data, const Shape& shape) : Tensor(s
         std::cerr << "Error: Tensor data size mismatch" << std::endl;
         return;
     }
-    std::copy(data.begin(), data.end(), data_);
+    std::copy(data.begin(), data.end(), this->data());
 }
 
-Tensor::Tensor(const Tensor& other) : 
-    size_(other.size_), shape_(other.shape_), strides_(other.strides_), owns_memory_(true) {
-    if (other.data_) {
-        data_ = static_cast<float*>(aligned_alloc(size_ * sizeof(float)));
-        std::memcpy(data_, other.data_, size_ * sizeof(float));
-    } else {
-        data_ = nullptr;
+Tensor::Tensor(std::shared_ptr<Storage> storage, void* data, DType dtype,
+               const Shape& shape, const Strides& strides)
+    : storage_(std::move(storage)), data_(data), dtype_(dtype), shape_(shape), strides_(strides),
+      owns_memory_(false) {
+    size_ = 1;
+    for (auto dim : shape) {
+        size_ *= dim;
     }
 }
 
+Tensor::Tensor(const Tensor& other) = default;
+
 Tensor::Tensor(Tensor&& other) noexcept :
-    data_(other.data_), size_(other.size_), shape_(std::move(other.shape_)), strides_(std::move(other.strides_)), owns_memory_(other.owns_memory_) {
+    storage_(std::move(other.storage_)), data_(other.data_), dtype_(other.dtype_), size_(other.size_),
+    shape_(std::move(other.shape_)), strides_(std::move(other.strides_)), owns_memory_(other.owns_memory_) {
     other.data_ = nullptr;
     other.size_ = 0;
     other.owns_memory_ = false;
 }
 
-Tensor& Tensor::operator=(const Tensor& other) {
-    if (this == &other) return *this;
-
-    if (owns_memory_ && data_) {
-        aligned_free(data_);
-    }
-
-    size_ = other.size_;
-    shape_ = other.shape_;
-    strides_ = other.strides_;
-    owns_memory_ = true;
-
-    if (other.data_) {
-        data_ = static_cast<float*>(aligned_alloc(size_ * sizeof(float)));
-        std::memcpy(data_, other.data_, size_ * sizeof(float));
-    } else {
-        data_ = nullptr;
-    }
-    return *this;
-}
+Tensor& Tensor::operator=(const Tensor& other) = default;
 
 Tensor& Tensor::operator=(Tensor&& other) noexcept {
     if (this == &other) return *this;
 
-    if (owns_memory_ && data_) {
-        aligned_free(data_);
-    }
-
+    storage_ = std::move(other.storage_);
     data_ = other.data_;
+    dtype_ = other.dtype_;
     size_ = other.size_;
     shape_ = std::move(other.shape_);
     strides_ = std::move(other.strides_);
@@ -94,10 +136,154 @@ Tensor& Tensor::operator=(Tensor&& other) noexcept {
     return *this;
 }
 
-Tensor::~Tensor() {
-    if (owns_memory_ && data_) {
-        aligned_free(data_);
+Tensor::~Tensor() = default;
+
+void* Tensor::element(size_t offset) const {
+    return static_cast<char*>(data_) + offset * element_size();
+}
+
+void Tensor::copy_to(void* dst) const {
+    if (is_contiguous()) {
+        std::memcpy(dst, data_, size_ * element_size());
+        return;
+    }
+
+    if (dtype_ == DType::Float32) {
+        copy_elements(shape_, size_, static_cast<float*>(dst), compute_strides(shape_),
+                      static_cast<const float*>(data_), strides_);
+    } else {
+        copy_elements(shape_, size_, static_cast<uint16_t*>(dst), compute_strides(shape_),
+                      static_cast<const uint16_t*>(data_), strides_);
+    }
+}
+
+bool Tensor::is_contiguous() const {
+    size_t expected = 1;
+    for (size_t i = shape_.size(); i-- > 0;) {
+        if (shape_[i] == 1) continue;
+        if (strides_[i] != expected) return false;
+        expected *= shape_[i];
+    }
+    return true;
+}
+
+void Tensor::assign_values(const Tensor& values) {
+    if (dtype_ == DType::Float32) {
+        copy_elements(shape_, size_, data(), strides_, values.data(), values.strides_);
+        return;
+    }
+    Tensor narrowed = values.to(dtype_);
+    copy_elements(shape_, size_, static_cast<uint16_t*>(raw_data()), strides_,
+                  static_cast<const uint16_t*>(narrowed.data_), narrowed.strides_);
+}
+
+Tensor Tensor::view(const Shape& shape) const {
+    size_t n = 1;
+    for (auto dim : shape) {
+        n *= dim;
+    }
+    if (n != size_) {
+        throw std::invalid_argument("view: shape does not match the number of elements");
     }
+    if (!is_contiguous()) {
+        throw std::invalid_argument("view: tensor is not contiguous, use reshape()");
+    }
+    return Tensor(storage_, data_, dtype_, shape, compute_strides(shape));
+}
+
+Tensor Tensor::reshape(const Shape& shape) const {
+    if (is_contiguous()) {
+        return view(shape);
+    }
+    return contiguous().view(shape);
+}
+
+Tensor Tensor::slice(size_t dim, size_t start, size_t end) const {
+    if (dim >= shape_.size() || start > end || end > shape_[dim]) {
+        throw std::out_of_range("slice: range out of bounds");
+    }
+    Shape shape = shape_;
+    shape[dim] = end - start;
+    return Tensor(storage_, element(start * strides_[dim]), dtype_, shape, strides_);
+}
+
+Tensor Tensor::narrow(size_t dim, size_t start, size_t length) const {
+    return slice(dim, start, start + length);
+}
+
+Tensor Tensor::permute(const std::vector<size_t>& dims) const {
+    if (dims.size() != shape_.size()) {
+        throw std::invalid_argument("permute: wrong number of dimensions");
+    }
+    Shape shape(dims.size());
+    Strides strides(dims.size());
+    std::vector<bool> seen(dims.size(), false);
+    for (size_t i = 0; i < dims.size(); ++i) {
+        if (dims[i] >= dims.size() || seen[dims[i]]) {
+            throw std::invalid_argument("permute: dims must be a permutation");
+        }
+        seen[dims[i]] = true;
+        shape[i] = shape_[dims[i]];
+        strides[i] = strides_[dims[i]];
+    }
+    return Tensor(storage_, data_, dtype_, shape, strides);
+}
+
+Tensor Tensor::transpose(size_t dim0, size_t dim1) const {
+    std::vector<size_t> dims(shape_.size());
+    std::iota(dims.begin(), dims.end(), 0);
+    if (dim0 >= dims.size() || dim1 >= dims.size()) {
+        throw std::out_of_range("transpose: dimension out of range");
+    }
+    std::swap(dims[dim0], dims[dim1]);
+    return permute(dims);
+}
+
+Tensor Tensor::contiguous() const {
+    if (is_contiguous()) {
+        return *this;
+    }
+    return clone();
+}
+
+Tensor Tensor::clone() const {
+    if (!data_) {
+        return Tensor();
+    }
+    Tensor result(shape_, dtype_);
+    copy_to(result.data_);
+    return result;
+}
+
+Tensor Tensor::to(DType dtype) const {
+    if (dtype == dtype_) {
+        return *this;
+    }
+    if (!data_) {
+        return Tensor();
+    }
+    if (dtype_ != DType::Float32 && dtype != DType::Float32) {
+        return to(DType::Float32).to(dtype);
+    }
+
+    Tensor src = contiguous();
+    Tensor result(shape_, dtype);
+    if (dtype_ == DType::Float32) {
+        const kernels::NarrowKernel narrow = narrow_kernel(dtype);
+        const float* x = src.data();
+        uint16_t* y = static_cast<uint16_t*>(result.data_);
+        parallel_for(0, size_, CONVERT_GRAIN, [&](size_t begin, size_t end) {
+            narrow(x + begin, y + begin, end - begin);
+        });
+    } else {
+        const kernels::WidenKernel widen = widen_kernel(dtype_);
+        const uint16_t* x = static_cast<const uint16_t*>(src.data_);
+        float* y = result.data();
+        parallel_for(0, size_, CONVERT_GRAIN, [&](size_t begin, size_t end) {
+            widen(x + begin, y + begin, end - begin);
+        });
+    }
+    return result;
 }
 
 Tensor::Strides Tensor::compute_strides(const Shape& shape) {
@@ -115,7 +301,7 @@ float& Tensor::at(const std::vector<size_t>& indices) {
     for (size_t i = 0; i < indices.size(); ++i) {
         offset += indices[i] * strides_[i];
     }
-    return data_[offset];
+    return data()[offset];
 }
 
 const float& Tensor::at(const std::vector<size_t>& indices) const {
@@ -123,15 +309,19 @@ const float& Tensor::at(const std::vector<size_t>& indices) const {
     for (size_t i = 0; i < indices.size(); ++i) {
         offset += indices[i] * strides_[i];
     }
-    return data_[offset];
+    return data()[offset];
+}
+
+void Tensor::throw_not_float32() const {
+    throw std::logic_error(std::string("float32 access to a ") + dtype_name(dtype_) + " tensor");
 }
 
 float& Tensor::operator[](size_t index) {
-    return data_[index];
+    return data()[index];
 }
 
 const float& Tensor::operator[](size_t index) const {
-    return data_[index];
+    return data()[index];
 }
 
 float& Tensor::operator[](std::initializer_list<size_t> indices) {
@@ -141,7 +331,7 @@ float& Tensor::operator[](std::initializer_list<size_t> indices) {
         offset += index * strides_[i];
         i++;
     }
-    return data_[offset];
+    return data()[offset];
 }
 
 const float& Tensor::operator[](std::initializer_list<size_t> indices) const {
@@ -151,25 +341,62 @@ const float& Tensor::operator[](std::initializer_list<size_t> indices) const {
         offset += index * strides_[i];
         i++;
     }
-    return data_[offset];
+    return data()[offset];
 }
 
 void Tensor::fill(float value) {
-    for (size_t i = 0; i < size_; ++i) {
-        data_[i] = value;
+    if (dtype_ != DType::Float32) {
+        uint16_t bits;
+        narrow_kernel(dtype_)(&value, &bits, 1);
+        fill_elements(shape_, size_, static_cast<uint16_t*>(raw_data()), strides_, bits);
+        return;
+    }
+    if (is_contiguous()) {
+        std::fill(data(), data() + size_, value);
+        return;
     }
+    fill_elements(shape_, size_, data(), strides_, value);
 }
 
 void Tensor::randn(float mean, float std) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::normal_distribution<float> d(mean, std);
-    for (size_t i = 0; i < size_; ++i) {
-        data_[i] = d(gen);
+    randn(mean, std, default_generator());
+}
+
+void Tensor::randn(float mean, float std, Generator& gen) {
+    if (dtype_ == DType::Float32 && is_contiguous()) {
+            gen.normal(data(), size_, mean, std);
+        return;
+    }
+    Tensor values(shape_);
+    values.randn(mean, std, gen);
+    assign_values(values);
+}
+
+void Tensor::rand(float low, float high) {
+    rand(low, high, default_generator());
+}
+
+void Tensor::rand(float low, float high, Generator& gen) {
+    if (dtype_ == DType::Float32 && is_contiguous()) {
+            gen.uniform(data(), size_, low, high);
+        return;
     }
+    Tensor values(shape_);
+    values.rand(low, high, gen);
+    assign_values(values);
 }
 
 void Tensor::print() const {
+    if (dtype_ != DType::Float32) {
+        std::cout << dtype_name(dtype_) << " ";
+        to(DType::Float32).print();
+        return;
+    }
+    if (!is_contiguous()) {
+        contiguous().print();
+        return;
+    }
+
     std::cout << "Tensor shape=(";
     for (size_t i = 0; i < shape_.size(); ++i) {
         std::cout << shape_[i] << (i < shape_.size() - 1 ? ", " : "");
@@ -178,7 +405,7 @@ void Tensor::print() const {
     
     if (size_ <= 100) {
         for (size_t i = 0; i < size_; ++i) {
-            std::cout << data_[i] << " ";
+            std::cout << data()[i] << " ";
             if ((i + 1) % (shape_.back()) == 0) std::cout << std::endl;
         }
     } else {
@@ -187,17 +414,26 @@ void Tensor::print() const {
 }
 
 bool Tensor::save(const std::string& filepath) const {
+    if (!is_contiguous()) {
+        return contiguous().save(filepath);
+    }
+
     std::ofstream file(filepath, std::ios::binary);
     if (!file.is_open()) {
         std::cerr << "Error: Cannot open file for writing: " << filepath << std::endl;
         return false;
     }
     
+    uint32_t dtype = static_cast<uint32_t>(dtype_);
+    file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    file.write(reinterpret_cast<const char*>(&FILE_VERSION), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&dtype), sizeof(uint32_t));
+
     size_t shape_size = shape_.size();
     file.write(reinterpret_cast<const char*>(&shape_size), sizeof(size_t));
     file.write(reinterpret_cast<const char*>(shape_.data()), shape_size * sizeof(size_t));
     file.write(reinterpret_cast<const char*>(&size_), sizeof(size_t));
-    file.write(reinterpret_cast<const char*>(data_), size_ * sizeof(float));
+    file.write(reinterpret_cast<const char*>(data_), size_ * element_size());
     
     file.close();
     return true;
@@ -210,6 +446,24 @@ Tensor Tensor::load(const std::string& filepath) {
         return Tensor();
     }
     
+    DType dtype = DType::Float32;
+    char magic[sizeof(FILE_MAGIC)];
+    file.read(magic, sizeof(magic));
+    if (std::memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0) {
+        uint32_t version = 0;
+        uint32_t dtype_value = 0;
+        file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&dtype_value), sizeof(uint32_t));
+        if (version != FILE_VERSION || !valid_dtype(dtype_value)) {
+            std::cerr << "Error: Unsupported tensor file format: " << filepath << std::endl;
+            return Tensor();
+        }
+        dtype = static_cast<DType>(dtype_value);
+    } else {
+        file.clear();
+        file.seekg(0);
+    }
+
     size_t shape_size;
     file.read(reinterpret_cast<char*>(&shape_size), sizeof(size_t));
     
@@ -219,8 +473,8 @@ Tensor Tensor::load(const std::string& filepath) {
     size_t size;
     file.read(reinterpret_cast<char*>(&size), sizeof(size_t));
     
-    Tensor result(shape);
-    file.read(reinterpret_cast<char*>(result.data_), size * sizeof(float));
+    Tensor result(shape, dtype);
+    file.read(reinterpret_cast<char*>(result.data_), size * result.element_size());
     
     file.close();
     return result;
@@ -0,0 +1,192 @@
+#include "core/thread_pool.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+
+namespace mtf {
+namespace core {
+
+namespace {
+
+thread_local bool in_parallel_region = false;
+
+// Marks the calling thread as inside a parallel region for its lifetime.
+struct ParallelRegion {
+    bool previous = in_parallel_region;
+    ParallelRegion() { in_parallel_region = true; }
+    ~ParallelRegion() { in_parallel_region = previous; }
+};
+
+size_t default_num_threads() {
+    if (const char* env = std::getenv("MTF_NUM_THREADS")) {
+        long value = std::strtol(env, nullptr, 10);
+        if (value > 0) {
+            return static_cast<size_t>(value);
+        }
+    }
+    size_t hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+std::mutex global_pool_mutex;
+std::unique_ptr<ThreadPool> global_pool;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t num_threads)
+    : task_(nullptr), num_tasks_(0), next_task_(0), remaining_(0), failed_(false),
+      active_(0), generation_(0), stop_(false) {
+    size_t workers = num_threads > 1 ? num_threads - 1 : 0;
+    workers_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::worker_loop() {
+    in_parallel_region = true;
+    uint64_t seen = 0;
+
+    while (true) {
+        const Task* task;
+        size_t num_tasks;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&]() { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            task = task_;
+            num_tasks = num_tasks_;
+            ++active_;
+        }
+
+        execute_tasks(task, num_tasks);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+        }
+        done_.notify_all();
+    }
+}
+
+// Once a task throws, the tasks not yet started are skipped. The first
+// exception is kept for run() to rethrow.
+void ThreadPool::execute_tasks(const Task* task, size_t num_tasks) {
+    size_t index;
+    while ((index = next_task_.fetch_add(1)) < num_tasks) {
+        if (!failed_.load(std::memory_order_relaxed)) {
+            try {
+                (*task)(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+                failed_.store(true, std::memory_order_relaxed);
+            }
+        }
+        remaining_.fetch_sub(1);
+    }
+}
+
+void ThreadPool::run(size_t num_tasks, const Task& task) {
+    if (num_tasks == 0) return;
+
+    std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+    if (workers_.empty() || in_parallel_region || !run_lock.owns_lock()) {
+        for (size_t i = 0; i < num_tasks; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [&]() { return active_ == 0; });
+        task_ = &task;
+        num_tasks_ = num_tasks;
+        next_task_.store(0);
+        remaining_.store(num_tasks);
+        failed_.store(false);
+        error_ = nullptr;
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    {
+        ParallelRegion region;
+        execute_tasks(&task, num_tasks);
+    }
+
+    // Workers may still be inside task, so wait for them even after a failure.
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&]() { return remaining_.load() == 0 && active_ == 0; });
+    task_ = nullptr;
+    std::exception_ptr error = std::move(error_);
+    error_ = nullptr;
+    lock.unlock();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+ThreadPool& ThreadPool::global() {
+    std::lock_guard<std::mutex> lock(global_pool_mutex);
+    if (!global_pool) {
+        global_pool = std::make_unique<ThreadPool>(default_num_threads());
+    }
+    return *global_pool;
+}
+
+void set_num_threads(size_t num_threads) {
+    std::lock_guard<std::mutex> lock(global_pool_mutex);
+    global_pool = std::make_unique<ThreadPool>(std::max<size_t>(num_threads, 1));
+}
+
+size_t get_num_threads() {
+    return ThreadPool::global().num_threads();
+}
+
+void parallel_for(size_t begin, size_t end, size_t grain,
+                  const std::function<void(size_t, size_t)>& fn) {
+    if (begin >= end) return;
+
+    size_t n = end - begin;
+    grain = std::max<size_t>(grain, 1);
+    if (n <= grain || in_parallel_region) {
+        fn(begin, end);
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::global();
+    size_t chunks = std::min(pool.num_threads(), (n + grain - 1) / grain);
+    if (chunks <= 1) {
+        fn(begin, end);
+        return;
+    }
+
+    size_t chunk_size = (n + chunks - 1) / chunks;
+    pool.run(chunks, [&](size_t c) {
+        size_t chunk_begin = begin + c * chunk_size;
+        size_t chunk_end = std::min(end, chunk_begin + chunk_size);
+        if (chunk_begin < chunk_end) {
+            fn(chunk_begin, chunk_end);
+        }
+    });
+}
+
+} // namespace core
+} // namespace mtf
@@ -0,0 +1,47 @@
+#include "core/vmath.hpp"
+#include "core/kernels.hpp"
+#include <cmath>
+
+namespace mtf {
+namespace core {
+namespace vmath {
+
+namespace reference {
+
+void exp(const float* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = std::exp(x[i]);
+}
+
+void log(const float* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = std::log(x[i]);
+}
+
+void tanh(const float* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = std::tanh(x[i]);
+}
+
+void sigmoid(const float* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] = 1.0f / (1.0f + std::exp(-x[i]));
+}
+
+} // namespace reference
+
+void exp(const float* x, float* y, size_t n) {
+    kernels::table().exp(x, y, n);
+}
+
+void log(const float* x, float* y, size_t n) {
+    kernels::table().log(x, y, n);
+}
+
+void tanh(const float* x, float* y, size_t n) {
+    kernels::table().tanh(x, y, n);
+}
+
+void sigmoid(const float* x, float* y, size_t n) {
+    kernels::table().sigmoid(x, y, n);
+}
+
+} // namespace vmath
+} // namespace core
+} // namespace mtf
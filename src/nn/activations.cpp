@@ -1,20 +1,64 @@
 #include "nn/activations.hpp"
+#include "autograd/capture.hpp"
 #include "core/ops_cpu.hpp"
+#include "core/vmath.hpp"
+#include <algorithm>
 
 namespace mtf {
 namespace nn {
 namespace functional {
 
+namespace {
+
+// Row-wise softmax of a contiguous [rows, cols] input into out.
+void softmax_rows(const core::Tensor& input, core::Tensor& out) {
+    size_t rows = input.shape()[0];
+    size_t cols = input.shape()[1];
+
+    const float* in_ptr = input.data();
+    float* out_ptr = out.data();
+    
+    for (size_t i = 0; i < rows; ++i) {
+        const float* in_row = in_ptr + i * cols;
+        float* out_row = out_ptr + i * cols;
+
+        float max_val = -1e9;
+        for (size_t j = 0; j < cols; ++j) {
+            max_val = std::max(max_val, in_row[j]);
+        }
+        for (size_t j = 0; j < cols; ++j) {
+            out_row[j] = in_row[j] - max_val;
+        }
+        core::vmath::exp(out_row, out_row, cols);
+
+        float sum_exp = 0.0f;
+        for (size_t j = 0; j < cols; ++j) {
+            sum_exp += out_row[j];
+        }
+        float inv_sum = 1.0f / sum_exp;
+        for (size_t j = 0; j < cols; ++j) {
+            out_row[j] *= inv_sum;
+        }
+    }
+}
+
+} // namespace
+
 autograd::NodePtr relu(autograd::NodePtr input) {
-    auto result = autograd::Node::create(core::ops::relu(input->value), 
-                                         input->requires_grad, 
-                                         "ReLU");
+    bool req_grad = autograd::grad_enabled() && input->requires_grad;
+    auto result = autograd::Node::create(core::ops::relu(input->value), req_grad, "ReLU");
+    if (auto* capture = autograd::CapturedStep::recording()) {
+        capture->record(result, {input}, [self = result.get(), input = input.get()]() {
+            core::ops::relu(input->value, self->value);
+        });
+    }
+    if (!req_grad) return result;
     result->parents = {input};
 
-    result->backward_fn = [result, input]() {
+    result->backward_fn = [self = result.get(), input]() {
         if (input->requires_grad) {
             const float* in_data = input->value.data();
-            const float* grad_out = result->grad.data();
+            const float* grad_out = self->grad.data();
             float* grad_in = input->grad.data();
             size_t size = input->value.size();
             
@@ -29,15 +73,20 @@ autograd::NodePtr relu(autograd::NodePtr input) {
 }
 
 autograd::NodePtr sigmoid(autograd::NodePtr input) {
-    auto result = autograd::Node::create(core::ops::sigmoid(input->value), 
-                                         input->requires_grad, 
-                                         "Sigmoid");
+    bool req_grad = autograd::grad_enabled() && input->requires_grad;
+    auto result = autograd::Node::create(core::ops::sigmoid(input->value), req_grad, "Sigmoid");
+    if (auto* capture = autograd::CapturedStep::recording()) {
+        capture->record(result, {input}, [self = result.get(), input = input.get()]() {
+            core::ops::sigmoid(input->value, self->value);
+        });
+    }
+    if (!req_grad) return result;
     result->parents = {input};
 
-    result->backward_fn = [result, input]() {
+    result->backward_fn = [self = result.get(), input]() {
         if (input->requires_grad) {
-            const float* y_data = result->value.data();
-            const float* grad_out = result->grad.data();
+            const float* y_data = self->value.data();
+            const float* grad_out = self->grad.data();
             float* grad_in = input->grad.data();
             size_t size = input->value.size();
 
@@ -51,15 +100,20 @@ autograd::NodePtr sigmoid(autograd::NodePtr input) {
 }
 
 autograd::NodePtr tanh(autograd::NodePtr input) {
-    auto result = autograd::Node::create(core::ops::tanh(input->value), 
-                                         input->requires_grad, 
-                                         "Tanh");
+    bool req_grad = autograd::grad_enabled() && input->requires_grad;
+    auto result = autograd::Node::create(core::ops::tanh(input->value), req_grad, "Tanh");
+    if (auto* capture = autograd::CapturedStep::recording()) {
+        capture->record(result, {input}, [self = result.get(), input = input.get()]() {
+            core::ops::tanh(input->value, self->value);
+        });
+    }
+    if (!req_grad) return result;
     result->parents = {input};
 
-    result->backward_fn = [result, input]() {
+    result->backward_fn = [self = result.get(), input]() {
         if (input->requires_grad) {
-            const float* y_data = result->value.data();
-            const float* grad_out = result->grad.data();
+            const float* y_data = self->value.data();
+            const float* grad_out = self->grad.data();
             float* grad_in = input->grad.data();
             size_t size = input->value.size();
 
@@ -75,37 +129,24 @@ autograd::NodePtr tanh(autograd::NodePtr input) {
 autograd::NodePtr softmax(autograd::NodePtr input) {
     size_t rows = input->value.shape()[0];
     size_t cols = input->value.shape()[1];
-    
+
     core::Tensor out_tensor(input->value.shape());
-    
-    const float* in_ptr = input->value.data();
-    float* out_ptr = out_tensor.data();
-    
-    for (size_t i = 0; i < rows; ++i) {
-        float max_val = -1e9;
-        for (size_t j = 0; j < cols; ++j) {
-            max_val = std::max(max_val, in_ptr[i * cols + j]);
-        }
-        
-        float sum_exp = 0.0f;
-        for (size_t j = 0; j < cols; ++j) {
-            float val = std::exp(in_ptr[i * cols + j] - max_val);
-            out_ptr[i * cols + j] = val;
-            sum_exp += val;
-        }
-        
-        for (size_t j = 0; j < cols; ++j) {
-            out_ptr[i * cols + j] /= sum_exp;
-        }
+    softmax_rows(input->value, out_tensor);
+
+    bool req_grad = autograd::grad_enabled() && input->requires_grad;
+    auto result = autograd::Node::create(std::move(out_tensor), req_grad, "Softmax");
+    if (auto* capture = autograd::CapturedStep::recording()) {
+        capture->record(result, {input}, [self = result.get(), input = input.get()]() {
+            softmax_rows(input->value, self->value);
+        });
     }
-    
-    auto result = autograd::Node::create(out_tensor, input->requires_grad, "Softmax");
+    if (!req_grad) return result;
     result->parents = {input};
     
-    result->backward_fn = [result, input, rows, cols]() {
+    result->backward_fn = [self = result.get(), input, rows, cols]() {
         if (input->requires_grad) {
-            const float* y_ptr = result->value.data();
-            const float* dy_ptr = result->grad.data();
+            const float* y_ptr = self->value.data();
+            const float* dy_ptr = self->grad.data();
             float* dx_ptr = input->grad.data();
             
             for (size_t i = 0; i < rows; ++i) {
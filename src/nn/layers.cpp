@@ -1,8 +1,12 @@
 #include "nn/layers.hpp"
+#include "autograd/capture.hpp"
+#include "nn/activations.hpp"
 #include "core/ops_cpu.hpp"
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 
 namespace mtf {
 namespace nn {
@@ -35,12 +39,84 @@ void Dense::init_parameters(size_t input_dim, size_t output_dim) {
     }
 }
 
+namespace {
+
+autograd::NodePtr apply_activation(const autograd::NodePtr& x, core::ops::Activation act) {
+    switch (act) {
+        case core::ops::Activation::Relu: return functional::relu(x);
+        case core::ops::Activation::Sigmoid: return functional::sigmoid(x);
+        case core::ops::Activation::Tanh: return functional::tanh(x);
+        case core::ops::Activation::None: break;
+    }
+    return x;
+}
+
+} // namespace
+
 autograd::NodePtr Dense::forward(autograd::NodePtr input) {
-    auto output = autograd::matmul(input, weight_);
+    // The packed path records nothing, so it is only for outputs that need no
+    // graph: a captured step has to recompute them, and with grad enabled
+    // they need one as soon as the input or a parameter requires grad.
+    bool needs_grad = input->requires_grad || weight_->requires_grad || (use_bias_ && bias_->requires_grad);
+    if (!frozen_ || (needs_grad && autograd::grad_enabled()) || autograd::CapturedStep::recording()) {
+        return apply_activation(autograd::linear(input, weight_, use_bias_ ? bias_ : nullptr), activation_);
+    }
+
+    const core::Tensor& x = input->value;
+    const core::Tensor& w = weight_->value;
+    const core::Tensor no_bias;
+    const core::Tensor& b = use_bias_ ? bias_->value : no_bias;
+    if (x.shape()[0] == 1) {
+        return autograd::Node::create(core::ops::linear_row(x, w, b, activation_), false, "Dense");
+    }
+
+    if (!packed_weight_current()) {
+        pack_weight();
+    }
+    size_t M = x.shape()[0];
+    size_t N = packed_weight_.cols();
+
+    core::Tensor out({M, N});
+    float beta = 0.0f;
     if (use_bias_) {
-        output = output + bias_; 
+        const core::Tensor b32 = b.to(core::DType::Float32);
+        const float* b_ptr = b32.data();
+        float* out_ptr = out.data();
+        for (size_t i = 0; i < M; ++i) {
+            std::copy(b_ptr, b_ptr + N, out_ptr + i * N);
+        }
+        beta = 1.0f;
     }
-    return output;
+    core::ops::gemm(false, 1.0f, x, packed_weight_, beta, out);
+    core::ops::apply_activation(out, activation_);
+    return autograd::Node::create(std::move(out), false, "Dense");
+}
+
+void Dense::freeze() {
+    frozen_ = true;
+    pack_weight();
+}
+
+void Dense::unfreeze() {
+    frozen_ = false;
+    packed_weight_ = core::PackedMatrix();
+    packed_source_ = core::Tensor();
+}
+
+bool Dense::packed_weight_current() const {
+    const core::Tensor& w = weight_->value;
+    return !packed_weight_.empty() &&
+           packed_source_.raw_data() == w.raw_data() &&
+           packed_source_.shape() == w.shape() &&
+           packed_source_.strides() == w.strides() &&
+           packed_version_ == w.version();
+}
+
+void Dense::pack_weight() {
+    const core::Tensor& w = weight_->value;
+    packed_version_ = w.version();
+    packed_weight_ = core::ops::pack_gemm_rhs(w);
+    packed_source_ = w;
 }
 
 std::vector<autograd::NodePtr> Dense::parameters() const {
@@ -108,7 +184,53 @@ Dense Dense::load(const std::string& filepath) {
         bias.fill(0.0f);
     }
     
-    return Dense(input_dim, output_dim, use_bias != 0, weight, bias);
+    Dense dense(input_dim, output_dim, use_bias != 0, weight, bias);
+    dense.freeze();
+    return dense;
+}
+
+QuantizedDense::QuantizedDense(const Dense& dense, bool fuse_relu)
+    : weights_(std::make_shared<const core::quant::Int8Weights>(dense.weight()->value)),
+      fuse_relu_(fuse_relu) {
+    if (dense.activation() == core::ops::Activation::Relu) {
+        fuse_relu_ = true;
+    } else if (dense.activation() != core::ops::Activation::None) {
+        if (fuse_relu) {
+            throw std::invalid_argument("QuantizedDense: fuse_relu on a layer that has another activation");
+        }
+        activation_ = dense.activation();
+    }
+    if (dense.use_bias()) {
+        bias_ = dense.bias()->value.contiguous();
+    }
+}
+
+autograd::NodePtr QuantizedDense::forward(autograd::NodePtr input) {
+    core::Tensor out = core::quant::linear(input->value, *weights_, bias_, input_scale_, fuse_relu_);
+    core::ops::apply_activation(out, activation_);
+    auto result = autograd::Node::create(out, false, "QuantizedDense");
+    if (auto* capture = autograd::CapturedStep::recording()) {
+        capture->record(result, {input},
+                        [self = result.get(), input = input.get(), weights = weights_, bias = bias_,
+                         scale = input_scale_, relu = fuse_relu_, activation = activation_]() {
+            core::quant::linear(input->value, *weights, bias, self->value, scale, relu);
+            core::ops::apply_activation(self->value, activation);
+        });
+    }
+    return result;
+}
+
+std::vector<autograd::NodePtr> QuantizedDense::parameters() const {
+    return {};
+}
+
+void QuantizedDense::calibrate(const core::Tensor& input) {
+    core::Tensor x = input.to(core::DType::Float32).contiguous();
+    float absmax = 0.0f;
+    for (size_t i = 0; i < x.size(); ++i) {
+        absmax = std::max(absmax, std::fabs(x[i]));
+    }
+    input_scale_ = std::max(input_scale_, absmax / 127.0f);
 }
 
 } // namespace nn
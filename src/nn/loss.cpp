@@ -1,31 +1,60 @@
 #include "nn/loss.hpp"
+#include "autograd/capture.hpp"
 #include "core/ops_cpu.hpp"
+#include "core/vmath.hpp"
+#include <algorithm>
 
 namespace mtf {
 namespace nn {
 
+namespace {
+
+// Mean over the batch of -sum(target * log(prediction)); log_p is scratch of
+// the prediction's shape and total is a {1} scratch for the sum.
+float cross_entropy(const core::Tensor& prediction, const core::Tensor& target, core::Tensor& log_p,
+                    core::Tensor& total) {
+    size_t N = prediction.size();
+    float* log_ptr = log_p.data();
+    const float* p_ptr = prediction.data();
+    for (size_t i = 0; i < N; ++i) {
+        log_ptr[i] = std::max(p_ptr[i], 1e-7f);
+    }
+    core::vmath::log(log_ptr, log_ptr, N);
+
+    core::ops::mul_(log_p, target);
+    core::ops::sum(log_p, {}, false, total);
+    float loss_sum = total[0];
+    return -loss_sum / static_cast<float>(prediction.shape()[0]);
+}
+
+} // namespace
+
 autograd::NodePtr MSELoss::operator()(autograd::NodePtr prediction, autograd::NodePtr target) {
-    auto diff = prediction - target;
-    auto sq_diff = diff * diff;
-    
-    core::Tensor val = core::ops::mean(sq_diff->value);
-    auto result = autograd::Node::create(val, true, "MSELoss");
+    core::Tensor sq_diff = core::ops::sub(prediction->value, target->value);
+    core::ops::mul_(sq_diff, sq_diff);
+
+    core::Tensor val = core::ops::mean(sq_diff);
+    bool req_grad = autograd::grad_enabled() && prediction->requires_grad;
+    auto result = autograd::Node::create(val, req_grad, "MSELoss");
+    if (auto* capture = autograd::CapturedStep::recording()) {
+        capture->record(result, {prediction, target},
+                        [self = result.get(), prediction = prediction.get(), target = target.get(), sq_diff]() mutable {
+            core::ops::sub(prediction->value, target->value, sq_diff);
+            core::ops::mul_(sq_diff, sq_diff);
+            core::ops::mean(sq_diff, {}, false, self->value);
+        });
+    }
+    if (!req_grad) return result;
     result->parents = {prediction, target};
     
-    result->backward_fn = [result, prediction, target]() {
+    result->backward_fn = [self = result.get(), prediction, target]() {
         size_t N = prediction->value.size();
         float scale = 2.0f / static_cast<float>(N);
         
         if (prediction->requires_grad) {
-            float grad_loss = result->grad[0];
-            
-            auto p_data = prediction->value.data();
-            auto t_data = target->value.data();
-            auto p_grad = prediction->grad.data();
-            
-            for (size_t i = 0; i < N; ++i) {
-                p_grad[i] += grad_loss * scale * (p_data[i] - t_data[i]);
-            }
+            float grad_loss = self->grad[0];
+            core::ops::axpy(grad_loss * scale, prediction->value, prediction->grad);
+            core::ops::axpy(-grad_loss * scale, target->value, prediction->grad);
         }
     };
     
@@ -33,25 +62,30 @@ autograd::NodePtr MSELoss::operator()(autograd::NodePtr prediction, autograd::No
 }
 
 autograd::NodePtr CrossEntropyLoss::operator()(autograd::NodePtr prediction, autograd::NodePtr target) {
-    core::Tensor p_val = prediction->value;
-    core::Tensor t_val = target->value;
+    const core::Tensor& p_val = prediction->value;
+    const core::Tensor& t_val = target->value;
     
     size_t N = p_val.size();
     size_t batch_size = p_val.shape()[0];
     
-    float loss_sum = 0.0f;
-    for (size_t i = 0; i < N; ++i) {
-        float p = std::max(p_val[i], 1e-7f);
-        loss_sum -= t_val[i] * std::log(p);
-    }
-    float loss_mean = loss_sum / static_cast<float>(batch_size);
+    core::Tensor log_p(p_val.shape());
+    core::Tensor total({1});
+    float loss_mean = cross_entropy(p_val, t_val, log_p, total);
     
-    auto result = autograd::Node::create(core::Tensor(core::Tensor::Shape{1}, {loss_mean}), true, "CELoss");
+    bool req_grad = autograd::grad_enabled() && prediction->requires_grad;
+    auto result = autograd::Node::create(core::Tensor(core::Tensor::Shape{1}, {loss_mean}), req_grad, "CELoss");
+    if (auto* capture = autograd::CapturedStep::recording()) {
+        capture->record(result, {prediction, target},
+                        [self = result.get(), prediction = prediction.get(), target = target.get(), log_p, total]() mutable {
+            self->value[0] = cross_entropy(prediction->value, target->value, log_p, total);
+        });
+    }
+    if (!req_grad) return result;
     result->parents = {prediction};
     
-    result->backward_fn = [result, prediction, target, batch_size, N]() {
+    result->backward_fn = [self = result.get(), prediction, target, batch_size, N]() {
         if (prediction->requires_grad) {
-            float grad_loss = result->grad[0];
+            float grad_loss = self->grad[0];
             float scale = 1.0f / static_cast<float>(batch_size);
             
             auto p_data = prediction->value.data();
@@ -1,4 +1,5 @@
 #include "optim/sgd.hpp"
+#include "core/ops_cpu.hpp"
 
 namespace mtf {
 namespace optim {
@@ -8,13 +9,7 @@ SGD::SGD(std::vector<autograd::NodePtr> parameters, float learning_rate)
 
 void SGD::step() {
     for (auto& param : parameters_) {
-        float* p_data = param->value.data();
-        const float* g_data = param->grad.data();
-        size_t size = param->value.size();
-
-        for (size_t i = 0; i < size; ++i) {
-            p_data[i] -= learning_rate_ * g_data[i];
-        }
+        core::ops::axpy(-learning_rate_, param->grad, param->value);
     }
 }
 
@@ -0,0 +1,63 @@
+#include "mini_tf.hpp"
+#include <cmath>
+#include <iostream>
+
+using mtf::core::Tensor;
+
+namespace {
+
+int failures = 0;
+
+// y = x * w + b, computed directly from the layer's current parameters.
+Tensor reference(const mtf::nn::Dense& layer, const Tensor& x) {
+    Tensor y = mtf::core::ops::matmul(x, layer.weight()->value);
+    return mtf::core::ops::add(y, layer.bias()->value);
+}
+
+void check(const char* what, mtf::nn::Dense& layer, const Tensor& x) {
+    mtf::NoGradGuard no_grad;
+    Tensor y = layer(mtf::Variable(x, false))->value;
+    Tensor expected = reference(layer, x);
+    float diff = 0.0f;
+    for (size_t i = 0; i < y.size(); ++i) {
+        diff = std::max(diff, std::fabs(y[i] - expected[i]));
+    }
+    if (diff > 1e-4f) {
+        std::cerr << "FAIL " << what << " (rows " << x.shape()[0] << "): max diff " << diff << std::endl;
+        ++failures;
+    }
+}
+
+} // namespace
+
+// A frozen Dense must repack its weight after the weight is edited in place,
+// whichever mutable accessor the edit goes through.
+int main() {
+    for (size_t rows : {size_t(1), size_t(5)}) {
+        mtf::manual_seed(11);
+        mtf::nn::Dense layer(16, 8);
+        layer.freeze();
+        Tensor x({rows, 16});
+        x.randn();
+
+        check("after freeze", layer, x);
+
+        float* w = layer.weight()->value.data();
+        for (size_t i = 0; i < layer.weight()->value.size(); ++i) w[i] *= -2.0f;
+        check("after data()", layer, x);
+
+        layer.weight()->value[3] = 5.0f;
+        check("after operator[]", layer, x);
+
+        layer.weight()->value.at({2, 7}) = -4.0f;
+        check("after at()", layer, x);
+
+        layer.bias()->value.data()[0] = 9.0f;
+        check("after editing the bias", layer, x);
+    }
+
+    if (failures == 0) {
+        std::cout << "dense_freeze_test: ok" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}